@@ -18,13 +18,18 @@
 #include <unordered_map>
 #include <type_traits>
 #include <Logger.h>
+#include <IExecutor.h>
 #include <mutex>
 #include <optional>
+#include <list>
+#include <vector>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 //Furrball, compact and filled with spit !
@@ -57,12 +62,12 @@ namespace NuAtlas {
 #ifdef _WIN32
             DWORD oldProtect;
             if (!VirtualProtect(buffer, size, PAGE_READWRITE, &oldProtect)) {
-                Logger::getInstance().error("Failed to set memory protection on Windows");
+                FURR_LOG_ERROR("Failed to set memory protection on Windows");
                 return false;
             }
 #else
             if (mprotect(buffer, size, PROT_READ | PROT_WRITE) != 0) {
-                Logger::getInstance().error("Failed to set memory protection on Linux");
+                FURR_LOG_ERROR("Failed to set memory protection on Linux");
                 return false;
             }
 #endif
@@ -123,7 +128,11 @@ namespace NuAtlas {
     protected: 
         virtual void evict() = 0;
     public:
-        typedef void(*EvictionCallback)(Key&);
+        typedef std::function<void(Key&)> EvictionCallback;
+        /**
+         * @brief Receives count evicted key-value pairs at once, the span is only valid during the call.
+         */
+        typedef std::function<void(std::pair<Key, Value>* victims, size_t count)> BatchEvictionCallback;
         virtual bool contains(const Key& key)const noexcept = 0;
         virtual void touch(const Key& key)noexcept = 0;
         virtual void add(const Key& key, const Value& value) = 0;
@@ -134,12 +143,17 @@ namespace NuAtlas {
      * @brief Implements the ARC eviction policy
      * TODO: Implement Adaptive Memory Pooling (AMP)
      * You can create and manage your own cache separately by instantiating a Policy object and using it.
+     * The eviction callback is invoked whenever a resident key loses its value (demoted to a ghost list or dropped).
+     * With a batch eviction callback, an add that needs room evicts several victims at once and delivers them together.
      * @see S3FIFOPolicy
      * @see LRUPolicy
      * @see LFUPolicy
      */
     template<class Key, class Value>
     class ARCPolicy final : public Cache<Key, Value> {
+    public:
+        using typename Cache<Key, Value>::EvictionCallback;
+        using typename Cache<Key, Value>::BatchEvictionCallback;
     private:
         std::list<Key> t1;  // Recently added
         std::list<Key> t2;  // Recently used
@@ -151,43 +165,88 @@ namespace NuAtlas {
         size_t capacity;
         size_t p;  // Target size for t1
         EvictionCallback evictionCallback = [](Key&) {};//NO-OP by default.
+        BatchEvictionCallback batchEvictionCallback;
+        size_t batchSize = 1;
+        std::vector<std::pair<Key, Value>> victims;
+
+        /**
+         * @brief Removes the value of an evicted key, handing it to the callback or to the pending batch.
+         */
+        void drop(Key& old) {
+            auto it = map.find(old);
+            if (batchEvictionCallback) {
+                victims.emplace_back(old, std::move(it->second));
+                map.erase(it);
+                return;
+            }
+            map.erase(it);
+            evictionCallback(old);
+        }
 
-        void replace(const Key& key) {
-            if (!t1.empty() && (t1.size() > p || (std::find(b2.begin(), b2.end(), key) != b2.end() && t1.size() == p))) {
+        /**
+         * @brief Evicts for an add into a full cache, batchSize victims at once so the next adds find room.
+         */
+        void makeRoom(bool inB2) {
+            replace(inB2);
+            for (size_t i = 1; i < batchSize && (!t1.empty() || !t2.empty()); i++) {
+                replace(false);
+            }
+        }
+
+        void deliverVictims() {
+            if (!victims.empty()) {
+                batchEvictionCallback(victims.data(), victims.size());
+                victims.clear();
+            }
+        }
+
+        /**
+         * @brief Demotes the LRU resident of t1 or t2 to its ghost list.
+         * @param inB2 true if the key being brought in was found in b2.
+         */
+        void replace(bool inB2) {
+            Key old;
+            if (!t1.empty() && (t1.size() > p || (inB2 && t1.size() == p) || t2.empty())) {
                 // Move from t1 to b1
-                auto old = t1.back();
+                old = t1.back();
                 t1.pop_back();
                 b1.push_front(old);
-                map.erase(old);
             }
             else {
                 // Move from t2 to b2
-                auto old = t2.back();
+                old = t2.back();
                 t2.pop_back();
                 b2.push_front(old);
-                map.erase(old);
             }
+            drop(old);
         }
 
+        /**
+         * @brief Makes room for a key that is in neither the cache nor the ghost lists.
+         */
         void evict() override {
+            const size_t resident = t1.size() + t2.size();
             if (t1.size() + b1.size() >= capacity) {
                 if (t1.size() < capacity) {
-                    evictionCallback(b1.back());
                     b1.pop_back();
+                    if (resident >= capacity) {
+                        makeRoom(false);
+                    }
                 }
                 else {
-                    evictionCallback(t1.back());
-                    t1.pop_back();
+                    for (size_t i = 0; i < batchSize && !t1.empty(); i++) {
+                        Key old = t1.back();
+                        t1.pop_back();
+                        drop(old);
+                    }
                 }
             }
-            if (t1.size() + t2.size() + b1.size() + b2.size() >= 2 * capacity) {
-                if (t2.size() + b2.size() > capacity) {
-                    evictionCallback(b2.back());
+            else if (resident + b1.size() + b2.size() >= capacity) {
+                if (resident + b1.size() + b2.size() >= 2 * capacity) {
                     b2.pop_back();
                 }
-                else {
-                    evictionCallback(t2.back());
-                    t2.pop_back();
+                if (resident >= capacity) {
+                    makeRoom(false);
                 }
             }
         }
@@ -200,8 +259,17 @@ namespace NuAtlas {
         ARCPolicy(size_t cap) : capacity(cap), p(1) {}
 
         void setEvictionCallback(EvictionCallback cb) {
-            evictionCallback = cb;
+            evictionCallback = std::move(cb);
         };
+        /**
+         * @brief Delivers victims in batches instead of one eviction callback per key.
+         * @param size Victims evicted at once when an add needs room, at least 1.
+         */
+        void setBatchEvictionCallback(BatchEvictionCallback cb, size_t size) {
+            batchEvictionCallback = std::move(cb);
+            batchSize = (std::max)(size, size_t(1));
+            victims.reserve(batchSize);
+        }
         /**
          * @return true if the key exists.
          */
@@ -209,42 +277,79 @@ namespace NuAtlas {
             return map.find(key) != map.end();
         }
         /**
-         * @brief Promotes a Key.
+         * @return true if the key was evicted after being used more than once and is still remembered (in b2).
+         */
+        bool isFrequentGhost(const Key& key)const noexcept {
+            return std::find(b2.begin(), b2.end(), key) != b2.end();
+        }
+        /**
+         * @brief Inserts every key isFrequentGhost returns true for into out, one walk of b2 for many lookups.
+         */
+        template<class Set>
+        void frequentGhosts(Set& out)const {
+            out.insert(b2.begin(), b2.end());
+        }
+        /**
+         * @return The number of resident keys.
+         */
+        size_t size()const noexcept {
+            return t1.size() + t2.size();
+        }
+        /**
+         * @brief Demotes the count residents the policy would evict next, ahead of the adds that would need the room.
+         */
+        void reclaim(size_t count = 1) {
+            for (size_t i = 0; i < count && (!t1.empty() || !t2.empty()); i++) {
+                replace(false);
+            }
+            deliverVictims();
+        }
+        /**
+         * @brief Promotes a resident Key.
          */
         void touch(const Key& key)noexcept override {
-            if (std::find(t1.begin(), t1.end(), key) != t1.end()) {
-                t1.remove(key);
-                t2.push_front(key);
+            auto it = std::find(t1.begin(), t1.end(), key);
+            if (it != t1.end()) {
+                t2.splice(t2.begin(), t1, it);
+                return;
             }
-            else if (std::find(t2.begin(), t2.end(), key) != t2.end()) {
-                t2.splice(t2.begin(), t2, std::find(t2.begin(), t2.end(), key));
+            it = std::find(t2.begin(), t2.end(), key);
+            if (it != t2.end()) {
+                t2.splice(t2.begin(), t2, it);
             }
-            else if (std::find(b1.begin(), b1.end(), key) != b1.end()) {
+        }
+        /**
+         * @brief Adds a Key-Value Pair the the cache.
+         * 
+         * A key found in the ghost lists adapts the target size and is inserted directly into t2.
+         */
+        void add(const Key& key, const Value& value) override {
+            auto ghost = std::find(b1.begin(), b1.end(), key);
+            if (ghost != b1.end()) {
                 // Case when the key is in b1
-                p = min(capacity, p + max(b2.size() / b1.size(), 1UL));
-                replace(key);
-                b1.remove(key);
+                p = (std::min)(capacity, p + (std::max)(b2.size() / b1.size(), size_t(1)));
+                if (t1.size() + t2.size() >= capacity) {
+                    makeRoom(false);
+                }
+                b1.erase(ghost);
                 t2.push_front(key);
-                map[key] = Value();  // Assuming default constructor exists
             }
-            else if (std::find(b2.begin(), b2.end(), key) != b2.end()) {
+            else if ((ghost = std::find(b2.begin(), b2.end(), key)) != b2.end()) {
                 // Case when the key is in b2
-                p = max(0, static_cast<int>(p) - max(b1.size() / b2.size(), 1UL));
-                replace(key);
-                b2.remove(key);
+                const size_t delta = (std::max)(b1.size() / b2.size(), size_t(1));
+                p = p > delta ? p - delta : 0;
+                if (t1.size() + t2.size() >= capacity) {
+                    makeRoom(true);
+                }
+                b2.erase(ghost);
                 t2.push_front(key);
-                map[key] = Value();  // Assuming default constructor exists
             }
-        }
-        /**
-         * @brief Adds a Key-Value Pair the the cache.
-         */
-        void add(const Key& key, const Value& value) override {
-            if (map.size() >= capacity) {
+            else {
                 evict();
+                t1.push_front(key);
             }
-            t1.push_front(key);
             map[key] = value;
+            deliverVictims();
         }
         /**
          * @brief Gets a value from the cache.
@@ -308,6 +413,67 @@ namespace NuAtlas {
 
     };
 
+    /**
+     * @brief Compression applied by the DB to a level of the LSM tree.
+     */
+    enum class FurrCompression : uint8_t {
+        None,
+        LZ4,
+        LZ4HC,
+        ZSTD
+    };
+
+    /**
+     * @brief Filter rearranging a page of typed data before it is compressed, undone when the page is loaded.
+     */
+    enum class FurrPageFilter : uint8_t {
+        None,
+        /**
+         * @brief Groups byte n of every element together, suits floats and wide integers whose high bytes vary little.
+         */
+        ByteShuffle,
+        /**
+         * @brief Groups bit n of every element together, suits small values stored in wide types.
+         */
+        BitShuffle,
+        /**
+         * @brief Stores every element as its difference to the previous one, suits sorted or slowly changing integers.
+         */
+        Delta
+    };
+
+    enum class FurrSchedulingPolicy : uint8_t {
+        Normal,
+        /**
+         * @brief SCHED_BATCH on Linux: never preempts interactive threads on wakeup. Below normal priority on Windows.
+         */
+        Batch,
+        /**
+         * @brief SCHED_IDLE on Linux: only runs on otherwise idle cores. Idle priority on Windows.
+         */
+        Idle
+    };
+
+    /**
+     * @brief Where and how a class of FurrBall's own threads runs, applied by each thread when it starts.
+     */
+    struct FurrThreadPolicy final {
+        /**
+         * @brief Cores the threads may run on, bit n for core n. 0 (default) leaves them to the OS.
+         */
+        uint64_t AffinityMask = 0;
+        FurrSchedulingPolicy Policy = FurrSchedulingPolicy::Normal;
+        /**
+         * @brief Nice value, -20 to 19. Ignored by the Idle policy.
+         */
+        int Nice = 0;
+
+        bool operator==(const FurrThreadPolicy& other) const noexcept {
+            return AffinityMask == other.AffinityMask && Policy == other.Policy && Nice == other.Nice;
+        }
+        bool operator!=(const FurrThreadPolicy& other) const noexcept { return !(*this == other); }
+    };
+
     struct FurrConfig final {
         /**
          * @brief The limit size after which the AMP will not allocate more pages. 1MB by default
@@ -323,11 +489,100 @@ namespace NuAtlas {
          * @brief The size of each page. 4KB by default.
          */
         size_t PageSize = 4096;
+        /**
+         * @brief Values at least this large are kept in blob files instead of SSTs. 64KB by default.
+         * Never lower than a stored page, pages always stay in SSTs.
+         * @see FurrBall::StoreLargeData
+         */
+        size_t LargeDataThreshold = 64 * 1024;
+        /**
+         * @brief Large data is compressed in independent blocks of this size (4KB to 4MB), 64KB by default.
+         * Reading a range only decompresses the blocks covering it: smaller blocks cut random read amplification,
+         * larger ones compress better. Compressed with PageCompression's codec.
+         */
+        size_t LargeDataBlockSize = 64 * 1024;
+        /**
+         * @brief Codec FurrBall applies to every page itself, a page load decompresses straight into its frame.
+         * LZ4 (default), LZ4HC or None, ZSTD falls back to LZ4.
+         * LZ4 picks a codec per page: incompressible pages are stored raw, the others use LZ4 fast, or LZ4HC for
+         * cold pages if LZ4HCLevel is set. LZ4HC uses LZ4HC for every page.
+         * 
+         * When set, the DB stores pages without compression and the level compression settings below are ignored.
+         */
+        FurrCompression PageCompression = FurrCompression::LZ4;
+
+        /**
+         * @brief Acceleration of LZ4 fast for hot pages, higher values trade ratio for speed. 1 by default.
+         */
+        int LZ4Acceleration = 1;
+
+        /**
+         * @brief LZ4HC level (up to 12) cold pages are written back with, 0 by default: pages are written with LZ4 fast.
+         * 
+         * Write back runs on misses, LZ4HC there slows them down. Background recompression (RecompressIntervalSeconds)
+         * moves cold pages to LZ4HC later, at this level or 9 when it is 0. LZ4HC compression uses level 9 when it is 0.
+         */
+        int LZ4HCLevel = 0;
+
+        /**
+         * @brief Size of the LZ4 dictionary pages are compressed against, 32KB by default (at most 64KB). 0 disables it.
+         * 
+         * The dictionary is built once per ball from pages sampled as they are written back and kept in the DB,
+         * pages written before it exists are compressed without it.
+         */
+        size_t PageDictionaryBytes = 32 * 1024;
+
+        /**
+         * @brief Filter applied to pages before compression unless hinted otherwise, None by default.
+         * @see FurrBall::SetPageFilter
+         */
+        FurrPageFilter PageFilter = FurrPageFilter::None;
+        /**
+         * @brief Size in bytes of the elements PageFilter works on: 1, 2, 4 (default) or 8.
+         */
+        uint8_t PageElementSize = 4;
+
+        /**
+         * @brief Compression of L0 and L1, where hot and recently written pages are read from. LZ4 by default.
+         */
+        FurrCompression HotLevelCompression = FurrCompression::LZ4;
+
+        /**
+         * @brief Compression of the levels between L1 and the bottommost level. LZ4 by default.
+         */
+        FurrCompression LevelCompression = FurrCompression::LZ4;
+
+        /**
+         * @brief Compression of the bottommost level, holding cold and rarely read pages. ZSTD by default.
+         */
+        FurrCompression BottommostCompression = FurrCompression::ZSTD;
+
+        /**
+         * @brief Size of the dictionary used by the bottommost level, 16KB by default. 0 disables dictionaries.
+         * 
+         * Dictionaries are built per SST file from sampled pages when the file is written,
+         * ZSTD dictionaries are trained (ZDICT) while LZ4 uses the raw samples.
+         */
+        size_t CompressionDictionaryBytes = 16 * 1024;
+
         /**
          * @brief Sets the eviction callback.
          */
         ARCPolicy<size_t, void*>::EvictionCallback evictionCallback = [](size_t&) {};
 
+        /**
+         * @brief Receives every batch of evicted pages and their frames, the frames are not reused during the call.
+         * Runs under the ball's page table lock, forward the work elsewhere.
+         * nullptr by default.
+         */
+        ARCPolicy<size_t, void*>::BatchEvictionCallback batchEvictionCallback = nullptr;
+
+        /**
+         * @brief Pages evicted at once when a miss finds the cache full, written back in one batch.
+         * 8 by default, capped at an eighth of the cache.
+         */
+        size_t EvictionBatchSize = 8;
+
         /**
          * @brief Sets the hash function for cache validation.
          */
@@ -338,16 +593,102 @@ namespace NuAtlas {
          */
         std::function<void(const std::string&)> logFunction = nullptr;
 
+        /**
+         * @brief Seconds a page lives after being written back, expired pages read back zero-filled
+         * and are dropped by compaction. 0 (default) disables expiry.
+         */
+        size_t PageTTL = 0;
+
         /**
          * @brief Sets the threshold for resizing the memory pool.
          */
         size_t ResizeThreshold = 4;
 
         /**
-         * @brief The number of threads to use in burrst mode.
+         * @brief Bits per key of the SST bloom filters, 10 by default (about 1% false positives). 0 disables them.
+         * A page load skips the SST files whose filter rules its key out, see FurrStats::DB::BloomUseful.
+         */
+        double BloomBitsPerKey = 10;
+
+        /**
+         * @brief One page load out of PerfSampleInterval is profiled with RocksDB's PerfContext, see FurrStats::Sampled.
+         * 0 (default) disables sampling.
+         */
+        size_t PerfSampleInterval = 0;
+
+        /**
+         * @brief Upper bound in bytes per second of the auto-tuned rate limiter shared by flush and compaction.
+         * 0 (default) disables rate limiting.
+         * 
+         * Also lowers the IO and CPU priority of compaction threads. RocksDB's thread pools belong to Env::Default(),
+         * which every RocksDB instance of the process shares (in-memory balls included): compactions of all of them
+         * run at the lower priority from then on, for the life of the process.
+         */
+        size_t BackgroundBytesPerSecond = 0;
+
+        /**
+         * @brief Background I/O budget while a critical phase is active, 1MB/s by default.
+         * Ignored unless BackgroundBytesPerSecond is set.
+         * 
+         * The auto-tuner keeps the limit within [BackgroundBytesPerSecond / 20, BackgroundBytesPerSecond],
+         * lower budgets are raised to BackgroundBytesPerSecond / 20. Under sustained compaction demand the tuner
+         * also raises the limit again, by 5% every tuning period (about 10 seconds), during a long phase.
+         * Pass pauseBackgroundWork to EnterCriticalPhase to stop background I/O outright.
+         * @see FurrBall::EnterCriticalPhase
+         */
+        size_t CriticalBytesPerSecond = 1024 * 1024;
+
+        /**
+         * @brief Seconds between passes of the low priority thread recompressing cold pages with LZ4HC.
+         * Each pass handles a batch of stored pages and only rewrites the ones that shrink meaningfully.
+         * 0 (default) disables it. Ignored if PageCompression is None.
+         * With an Executor, passes are submitted as low priority tasks from page misses once the interval elapsed.
+         */
+        size_t RecompressIntervalSeconds = 0;
+
+        /**
+         * @brief Free frame watermarks of the background reclaimer, in pages.
+         * Once a miss leaves LowWatermark free frames or fewer, the reclaimer evicts pages until HighWatermark
+         * frames are free, writing dirty ones back in batches, so misses rarely evict on their own.
+         * HighWatermark 0 (default) disables it, a LowWatermark of 0 is half of HighWatermark.
+         * HighWatermark is capped at half the cache. With an Executor, reclaim passes are low priority tasks on it.
+         */
+        size_t FreeFrameLowWatermark = 0;
+        size_t FreeFrameHighWatermark = 0;
+
+        /**
+         * @brief The number of threads to use in burrst mode, 0 uses one per hardware thread.
+         * Burst workers preload pages, compress and decompress large data blocks and write back pages on shutdown.
+         * A pool whose thread policy has an affinity mask gets one worker per core of the mask instead.
          */
         size_t BurrstThreadCount = 4;
 
+        /**
+         * @brief Runs burst and background work on the application's own thread pool or job system instead.
+         * FurrBall then starts no threads of its own, burst mode is on and BurrstThreadCount is ignored.
+         * Not owned, it must outlive the ball. RocksDB flushes and compactions keep their own threads.
+         * Of the thread policies below only the affinity masks apply, passed as hints to Submit.
+         * nullptr by default.
+         */
+        IExecutor* Executor = nullptr;
+
+        /**
+         * @brief Burst workers reading and writing pages: preloads and the write back on shutdown.
+         */
+        FurrThreadPolicy IOThreads;
+
+        /**
+         * @brief Workers compressing and decompressing large data blocks.
+         * If it differs from IOThreads they get a pool of their own, one worker per core of its mask,
+         * BurrstThreadCount workers without a mask.
+         */
+        FurrThreadPolicy DecompressThreads;
+
+        /**
+         * @brief The cold page recompression and reclaimer threads, nice 19 by default.
+         */
+        FurrThreadPolicy MaintenanceThreads = { 0, FurrSchedulingPolicy::Normal, 19 };
+
         union {
             struct {
                 /**
@@ -356,8 +697,9 @@ namespace NuAtlas {
                 bool UseHybridPages : 1;
                 /**
                  * @brief Indicates whether the Furrballs are volatile.
-                 * Volatile Furrballs are not persistent caches, meaning if the page is evicted, data is lost. You can use an eviction callback.
-                 * false by default.
+                 * Volatile Furrballs are not persistent caches: evicted pages are spilled without WAL or fsync,
+                 * any existing DB at the path is discarded on creation and nothing survives closing the ball.
+                 * You can use an eviction callback. false by default.
                  */
                 bool IsVolatile : 1;
                 /**
@@ -373,11 +715,116 @@ namespace NuAtlas {
                  * @brief Enables or disables burst mode for parallel processing. false by default.
                  */
                 bool EnableBurstMode : 1;
+                /**
+                 * @brief Keeps the spill store of a volatile ball entirely in memory (no disk I/O at all).
+                 * Ignored unless IsVolatile is set. false by default.
+                 */
+                bool VolatileInMemory : 1;
+                /**
+                 * @brief Enables RocksDB tickers and histograms, see FurrStats::DB. false by default.
+                 */
+                bool EnableStatistics : 1;
             };
             uint8_t flags = 0; // For convenience in handling all flags at once, 0 by default.
         };
     };
 
+    /**
+     * @brief Snapshot of a FurrBall's counters.
+     * @see FurrBall::GetStats
+     */
+    struct FurrStats final {
+        size_t PageHits = 0;
+        size_t PageMisses = 0;
+        /**
+         * @brief Misses that waited for another thread already reading the page instead of reading it again.
+         */
+        size_t CoalescedMisses = 0;
+        size_t Evictions = 0;
+        /**
+         * @brief Evictions done by the background reclaimer, the others were paid by a miss.
+         */
+        size_t BackgroundEvictions = 0;
+        size_t WriteBacks = 0;
+        /**
+         * @brief Cold pages rewritten by the background recompression, and the stored bytes it saved.
+         */
+        size_t RecompressedPages = 0;
+        size_t RecompressedBytesSaved = 0;
+        /**
+         * @brief Nanoseconds FurrBall's own threads spent running work, index n for core n.
+         * Divide the difference of two snapshots by the time between them for the utilization of each core.
+         */
+        std::vector<uint64_t> CoreBusyNanos;
+
+        /**
+         * @brief Where the time of a profiled page load went. Times are in nanoseconds.
+         */
+        struct LoadBreakdown {
+            uint64_t TotalNanos = 0;
+            uint64_t MemtableNanos = 0;
+            uint64_t SstNanos = 0;
+            uint64_t BlockReadNanos = 0;
+            uint64_t DecompressNanos = 0;
+            uint64_t BlockReadBytes = 0;
+            uint64_t BlockReads = 0;
+            uint64_t BlockCacheHits = 0;
+            /**
+             * @brief SST files skipped thanks to the bloom filter.
+             */
+            uint64_t BloomUseful = 0;
+            /**
+             * @brief SST files the bloom filter let through.
+             */
+            uint64_t BloomPositive = 0;
+        };
+        /**
+         * @brief Perf context of sampled page loads, only filled when FurrConfig::PerfSampleInterval is set.
+         */
+        struct {
+            uint64_t SampledLoads = 0;
+            /**
+             * @brief Sum over every sampled load.
+             */
+            LoadBreakdown Total;
+            /**
+             * @brief The slowest sampled load.
+             */
+            LoadBreakdown Slowest;
+        } Sampled;
+
+        struct Histogram {
+            uint64_t Count = 0;
+            double Average = 0;
+            double Median = 0;
+            double P95 = 0;
+            double P99 = 0;
+            double Max = 0;
+        };
+        /**
+         * @brief Aggregate DB tickers and histograms, only filled when FurrConfig::EnableStatistics is set.
+         */
+        struct {
+            uint64_t BlockCacheHits = 0;
+            uint64_t BlockCacheMisses = 0;
+            uint64_t BloomUseful = 0;
+            uint64_t BloomPositive = 0;
+            uint64_t BloomTruePositive = 0;
+            uint64_t BytesRead = 0;
+            uint64_t BytesWritten = 0;
+            uint64_t CompactionReadBytes = 0;
+            uint64_t CompactionWriteBytes = 0;
+            /**
+             * @brief Pages dropped by the compaction filter.
+             */
+            uint64_t CompactionDroppedPages = 0;
+            uint64_t StallMicros = 0;
+            Histogram GetMicros;
+            Histogram WriteMicros;
+            Histogram SstReadMicros;
+        } DB;
+    };
+
     /**
     * @class FurrBall
     * @brief Furrballs are a LZ4 Compressed DB using RocksDB with Cache and Paging Logic.
@@ -445,9 +892,19 @@ namespace NuAtlas {
          */
         //ARCPolicy<size_t,void*> ARC = ARCPolicy<size_t,void*>();
 
-        FurrBall(const FurrConfig& config)noexcept;
+        FurrBall(const FurrConfig& config, size_t numPages)noexcept;
 
-        void OnEvict(size_t key)noexcept;
+        /**
+         * @brief Writes the evicted page back to the DB if dirty and returns its frame to the free pool.
+         * 
+         * Called by the cache policy with the page table lock held.
+         */
+        void OnEvict(std::pair<size_t, void*>* victims, size_t count)noexcept;
+
+        /**
+         * @brief Get() and GetReadOnly(), a write access marks the page dirty and invalidates it for the page listeners.
+         */
+        void* Access(void* vAddress, bool write)noexcept;
 
         constexpr size_t floorAddress(size_t address)const noexcept {
             return address & ~(PageSize - 1);
@@ -475,23 +932,106 @@ namespace NuAtlas {
         /**
          * Returns a pointer to the page that contains the vAddress. if vAddress is not found and is far from all pages available
          * Get() doesn't create an entry and considers the vAddress to be invalid to preserve "contingency".
+         * The page is considered dirty and will be written back when evicted.
          * 
          * @param vAddress a pointer to a virtual address used to index into the cache.
          * 
          * @returns a valid Pointer to memory on success or nullptr_t on error.
          */
-        void* Get(void* vAddress)noexcept {
-            //Snap to page border.
-            //Query the Cache for the page.
-            //if present return it
-            //reload page from db and push into cache
+        void* Get(void* vAddress)noexcept;
+        /**
+         * @brief Like Get() but the page is not marked dirty, nothing may be written through the returned pointer.
+         * 
+         * @returns a valid Pointer to memory on success or nullptr_t on error.
+         */
+        const void* GetReadOnly(void* vAddress)noexcept;
+        /**
+         * @brief Marks the page of vAddress dirty and invalidates it for the page listeners.
+         * 
+         * Get() invalidates when it hands out the pointer, a listener may read the page again before the write lands.
+         * Call this once the write through a Get() pointer is done to drop what was read in between.
+         */
+        void MarkDirty(void* vAddress)noexcept;
+        /**
+         * @brief Registers a function called with a page's address when the page is evicted, released, handed out
+         * for writing by Get() or marked dirty by MarkDirty(), so copies of its content (e.g. ObjectCache) can be dropped.
+         * 
+         * It runs with the page table locked: keep it short and do not call back into the ball.
+         * @returns an id for RemovePageListener.
+         */
+        size_t AddPageListener(std::function<void(size_t pageAddress)> listener)noexcept;
+        /**
+         * @brief Unregisters a listener, it is not called anymore once this returns.
+         */
+        void RemovePageListener(size_t id)noexcept;
+        size_t GetPageSize()const noexcept {
+            return PageSize;
         }
         /**
-         * @brief Large data is stored seperate and a pointer to it is added to the cache
-         * @param buffer The original data, a pointer to it is stored in the cache to avoid copying and moving data. Do not free.
+         * @brief Loads the pages covering [vAddress, vAddress + size) ahead of use, at most as many as the cache holds.
+         * 
+         * Pages are read and decompressed outside the page table lock, in parallel in burst mode.
+         * Preloaded pages are not dirty until accessed through Get().
+         * @returns the number of pages loaded.
+         */
+        size_t Preload(void* vAddress, size_t size)noexcept;
+        /**
+         * @brief Releases the page that contains vAddress, its content is discarded without write-back.
+         * 
+         * The stored copy is dropped by the next compaction instead of writing a delete tombstone.
+         * A released page reads back zero-filled.
+         */
+        void Release(void* vAddress)noexcept;
+        /**
+         * @brief Hints the type of data held by the page containing vAddress, so it is filtered before compression.
+         * 
+         * Takes effect on the page's next write-back and is stored with it. Filtered pages do not use the page dictionary.
+         * @param elementSize Size in bytes of the page's elements: 1, 2, 4 or 8.
+         * @returns false if the page is not resident or elementSize is not supported.
+         */
+        bool SetPageFilter(void* vAddress, FurrPageFilter filter, size_t elementSize)noexcept;
+        /**
+         * @brief Returns a snapshot of the ball's counters, sampled perf context and DB statistics.
+         */
+        FurrStats GetStats()const noexcept;
+        /**
+         * @brief Marks the start of a latency-critical phase (e.g. gameplay frames), calls can nest.
+         * 
+         * Background flush and compaction I/O is throttled to FurrConfig::CriticalBytesPerSecond right away,
+         * within the range the rate limiter's auto-tuner allows.
+         * @param pauseBackgroundWork Also pauses background work entirely. This waits for running jobs to finish,
+         * use it at a phase boundary where a short wait is acceptable.
+         */
+        void EnterCriticalPhase(bool pauseBackgroundWork = false)noexcept;
+        /**
+         * @brief Ends a phase started by EnterCriticalPhase, background work resumes when the outermost phase ends.
+         */
+        void LeaveCriticalPhase()noexcept;
+        /**
+         * @brief Large data is stored seperate from pages, in blob files that compaction does not rewrite.
+         * @param buffer The data to store, it is copied and can be freed once the call returns.
          * @param size Buffer size.
+         * @returns a handle to load the data back, 0 on failure.
+         */
+        size_t StoreLargeData(const void* buffer, size_t size)noexcept;
+        /**
+         * @brief Copies large data stored by StoreLargeData into buffer.
+         * @param buffer Destination, nothing is copied if it is smaller than the stored data.
+         * @param size Buffer size.
+         * @returns the size of the stored data, 0 if the handle is unknown.
+         */
+        size_t LoadLargeData(size_t handle, void* buffer, size_t size)noexcept;
+        /**
+         * @brief Copies part of large data stored by StoreLargeData into buffer, only the blocks covering it are decompressed.
+         * @param offset Offset of the first byte to copy within the stored data.
+         * @param size Buffer size, at most this many bytes are copied.
+         * @returns the number of bytes copied, 0 if the handle is unknown or offset is past the end.
+         */
+        size_t LoadLargeData(size_t handle, size_t offset, void* buffer, size_t size)noexcept;
+        /**
+         * @brief Deletes large data stored by StoreLargeData, blob garbage collection reclaims its space.
          */
-        void StoreLargeData(void* buffer, size_t size);
+        void ReleaseLargeData(size_t handle)noexcept;
 
         const LockablePage* GenerateLockablePage() {
 
@@ -0,0 +1,66 @@
+/*****************************************************************//**
+ * \file   IExecutor.h
+ * \brief  Interface to run FurrBall's background and burst work on an external thread pool or job system.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace NuAtlas {
+    enum class TaskPriority : uint8_t {
+        /**
+         * @brief Maintenance that can wait for idle cores (e.g. recompressing cold pages).
+         */
+        Low,
+        /**
+         * @brief Burst work a caller is waiting on.
+         */
+        Normal,
+        High
+    };
+
+    /**
+     * @brief Runs tasks for FurrBall, set through FurrConfig::Executor.
+     *
+     * Tasks never throw and may submit more tasks. A task may block on the completion of tasks it submitted,
+     * while it waits FurrBall calls RunPendingTask so a job system can run or switch to other work.
+     */
+    class IExecutor {
+    public:
+        using Task = std::function<void()>;
+
+        /**
+         * @brief Queues a task.
+         * @param priority A hint, executors without priorities may ignore it.
+         * @param affinityMask Cores the task should run on, bit n for core n, 0 for any. A hint as well.
+         */
+        virtual void Submit(Task task, TaskPriority priority = TaskPriority::Normal, uint64_t affinityMask = 0) = 0;
+
+        /**
+         * @brief Queues count tasks at once, the tasks are moved from.
+         * Override it if the executor can queue a batch cheaper than one task at a time.
+         */
+        virtual void SubmitBatch(Task* tasks, size_t count, TaskPriority priority = TaskPriority::Normal, uint64_t affinityMask = 0) {
+            for (size_t i = 0; i < count; i++) {
+                Submit(std::move(tasks[i]), priority, affinityMask);
+            }
+        }
+
+        /**
+         * @brief Runs one queued task on the calling thread, or yields the calling fiber.
+         * @returns false if nothing ran, the caller then yields its thread.
+         */
+        virtual bool RunPendingTask() { return false; }
+
+        /**
+         * @brief The number of tasks that can run at once, used to size parallel work.
+         */
+        virtual size_t GetConcurrency() const noexcept = 0;
+
+        virtual ~IExecutor() = default;
+    };
+}
@@ -5,14 +5,158 @@
  * \author The Sphynx
  * \date   July 2024
  *********************************************************************/
+#pragma once
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <unordered_map>
 #include <iostream>
+#include <Furrballs.h>
 
 
  namespace NuAtlas {
+      /**
+       * \brief Address unique to T, tells which type a factory builds without RTTI.
+       */
+      template<class T>
+      struct FactoryType {
+          static constexpr char Tag = 0;
+      };
+
+      /**
+       * \brief Per-type pool of object slots carved from MemoryManager chunks.
+       *
+       * Every thread keeps its own free list, creating and destroying objects only takes a lock when a thread runs
+       * out of slots or holds too many. Chunks are kept for the life of the process.
+       */
+      template<class T>
+      class ObjectPool final {
+      public:
+          /**
+           * \brief Constructs a T in a pooled slot.
+           * \return nullptr if no memory could be allocated.
+           */
+          template<class... CtorArgs>
+          static T* Create(CtorArgs&&... args) {
+              void* slot = Acquire();
+              if (!slot) {
+                  return nullptr;
+              }
+              return new (slot) T(std::forward<CtorArgs>(args)...);
+          }
+
+          /**
+           * \brief Destroys an object made by Create, its slot goes to the calling thread's free list.
+           */
+          static void Destroy(T* object) noexcept {
+              if (!object) {
+                  return;
+              }
+              object->~T();
+              Release(object);
+          }
+
+      private:
+          struct FreeSlot {
+              FreeSlot* Next;
+          };
+
+          static constexpr size_t SlotAlign = alignof(T) > alignof(FreeSlot) ? alignof(T) : alignof(FreeSlot);
+          static constexpr size_t SlotSize = ((sizeof(T) > sizeof(FreeSlot) ? sizeof(T) : sizeof(FreeSlot)) + SlotAlign - 1) / SlotAlign * SlotAlign;
+          /**
+           * \brief Slots moved between a thread and the shared list at once.
+           */
+          static constexpr size_t BatchSize = 32;
+          /**
+           * \brief The first slot of a chunk links the chunks together.
+           */
+          static constexpr size_t ChunkSlots = (64 * 1024 / SlotSize > BatchSize ? 64 * 1024 / SlotSize : BatchSize) + 1;
+
+          struct ThreadCache {
+              FreeSlot* Head = nullptr;
+              size_t Count = 0;
+
+              /**
+               * \brief Hands the slots of an exiting thread to the others.
+               */
+              ~ThreadCache() {
+                  if (Head) {
+                      Spill(*this, Count);
+                  }
+              }
+          };
+
+          inline static std::mutex Mutex;
+          inline static FreeSlot* Shared = nullptr;
+          inline static FreeSlot* Chunks = nullptr;
+
+          static ThreadCache& Cache() noexcept {
+              thread_local ThreadCache cache;
+              return cache;
+          }
+
+          static void* Acquire() {
+              ThreadCache& cache = Cache();
+              if (!cache.Head && !Refill(cache)) {
+                  return nullptr;
+              }
+              FreeSlot* slot = cache.Head;
+              cache.Head = slot->Next;
+              cache.Count--;
+              return slot;
+          }
+
+          static void Release(void* object) noexcept {
+              ThreadCache& cache = Cache();
+              cache.Head = new (object) FreeSlot{ cache.Head };
+              cache.Count++;
+              //A thread destroying what others create would hoard their slots.
+              if (cache.Count > BatchSize * 2) {
+                  Spill(cache, BatchSize);
+              }
+          }
+
+          static void Spill(ThreadCache& cache, size_t count) noexcept {
+              FreeSlot* first = cache.Head;
+              FreeSlot* last = first;
+              for (size_t i = 1; i < count; i++) {
+                  last = last->Next;
+              }
+              cache.Head = last->Next;
+              cache.Count -= count;
+              std::lock_guard<std::mutex> lock(Mutex);
+              last->Next = Shared;
+              Shared = first;
+          }
+
+          static bool Refill(ThreadCache& cache) {
+              std::lock_guard<std::mutex> lock(Mutex);
+              if (Shared) {
+                  for (size_t i = 0; i < BatchSize && Shared; i++) {
+                      FreeSlot* slot = Shared;
+                      Shared = slot->Next;
+                      slot->Next = cache.Head;
+                      cache.Head = slot;
+                      cache.Count++;
+                  }
+                  return true;
+              }
+              char* chunk = static_cast<char*>(MemoryManager::AllocateMemory(ChunkSlots * SlotSize));
+              if (!chunk) {
+                  return false;
+              }
+              Chunks = new (chunk) FreeSlot{ Chunks };
+              for (size_t i = ChunkSlots - 1; i > 0; i--) {
+                  cache.Head = new (chunk + i * SlotSize) FreeSlot{ cache.Head };
+              }
+              cache.Count += ChunkSlots - 1;
+              return true;
+          }
+      };
+
      /**
       * \brief Base class for factories.
       */
@@ -20,24 +164,68 @@
       public:
           virtual ~IFactory() = default;
           virtual void* create() const = 0;
+          /**
+           * \brief Builds an object from serialized bytes, e.g. the content of a page.
+           * \return nullptr if the factory does not deserialize.
+           */
+          virtual void* createFrom(const void* /*data*/, size_t /*size*/) const {
+              return nullptr;
+          }
+          /**
+           * \brief Destroys an object made by create, through the allocator it came from.
+           */
+          virtual void destroy(void* object) const = 0;
+          /**
+           * \brief The FactoryType tag of the objects create returns.
+           */
+          virtual const void* type() const noexcept = 0;
+      };
+
+      /**
+       * \brief Factory of a known type, make returns the object without casting from void*.
+       */
+      template<class Value>
+      class TypedFactory : public IFactory {
+      public:
+          virtual Value* make() const = 0;
+
+          virtual Value* makeFrom(const void* /*data*/, size_t /*size*/) const {
+              return nullptr;
+          }
+
+          void* create() const override {
+              return make();
+          }
+
+          void* createFrom(const void* data, size_t size) const override {
+              return makeFrom(data, size);
+          }
+
+          const void* type() const noexcept override {
+              return &FactoryType<Value>::Tag;
+          }
       };
 
       /**
        * \brief Templated derived class for specific factories.
        */
       template<class Value, class... Args>
-      class Factory : public IFactory {
+      class Factory : public TypedFactory<Value> {
       public:
           Factory(std::function<Value(Args...)> func, Args... args)
               : func_(func), args_(std::make_tuple(args...)) {}
 
-          void* create() const override {
+          Value* make() const override {
               return createImpl(std::index_sequence_for<Args...>{});
           }
 
+          void destroy(void* object) const override {
+              delete static_cast<Value*>(object);
+          }
+
       private:
           template<std::size_t... Is>
-          void* createImpl(std::index_sequence<Is...>) const {
+          Value* createImpl(std::index_sequence<Is...>) const {
               return new Value(func_(std::get<Is>(args_)...));
           }
 
@@ -45,28 +233,238 @@
           std::tuple<Args...> args_;
       };
 
+      /**
+       * \brief Factory constructing Value(args...) in place in its ObjectPool, no std::function and no heap allocation
+       * once the pool has slots.
+       */
+      template<class Value, class... Args>
+      class PooledFactory final : public TypedFactory<Value> {
+      public:
+          explicit PooledFactory(Args... args)
+              : args_(std::make_tuple(args...)) {}
+
+          Value* make() const override {
+              return makePooled();
+          }
+
+          /**
+           * \brief Non-virtual make, what FactoryRef calls so that creating inlines down to ObjectPool<Value>::Create.
+           */
+          Value* makePooled() const {
+              return createImpl(std::index_sequence_for<Args...>{});
+          }
+
+          void destroy(void* object) const override {
+              ObjectPool<Value>::Destroy(static_cast<Value*>(object));
+          }
+
+      private:
+          template<std::size_t... Is>
+          Value* createImpl(std::index_sequence<Is...>) const {
+              return ObjectPool<Value>::Create(std::get<Is>(args_)...);
+          }
+
+          std::tuple<Args...> args_;
+      };
+
+      /**
+       * \brief Typed handle to a registered PooledFactory, returned by StaticFactoryWrapper::addPooledFactoryRef.
+       * The type is known when it is made, so create skips the registry lookup, the type check and the virtual calls.
+       * Factories are never unregistered, a handle stays valid until exit.
+       */
+      template<class Value, class... Args>
+      class FactoryRef final {
+      public:
+          FactoryRef() noexcept = default;
+
+          /**
+           * \return nullptr if the handle is empty or no memory could be allocated.
+           */
+          Value* create() const {
+              return factory_ ? factory_->makePooled() : nullptr;
+          }
+
+          void destroy(Value* object) const noexcept {
+              ObjectPool<Value>::Destroy(object);
+          }
+
+          /**
+           * \brief Id of the factory in StaticFactoryWrapper, for the untyped calls.
+           */
+          unsigned int id() const noexcept {
+              return id_;
+          }
+
+          explicit operator bool() const noexcept {
+              return factory_ != nullptr;
+          }
+
+      private:
+          friend class StaticFactoryWrapper;
+
+          FactoryRef(const PooledFactory<Value, Args...>* factory, unsigned int id) noexcept
+              : factory_(factory), id_(id) {}
+
+          const PooledFactory<Value, Args...>* factory_ = nullptr;
+          unsigned int id_ = 0;
+      };
+
+      /**
+       * \brief Factory constructing Value(data, size) from serialized bytes in its ObjectPool, used by ObjectCache.
+       * Value must be constructible from (const void*, size_t), make alone returns nullptr.
+       */
+      template<class Value>
+      class PageObjectFactory final : public TypedFactory<Value> {
+      public:
+          Value* make() const override {
+              return nullptr;
+          }
+
+          Value* makeFrom(const void* data, size_t size) const override {
+              return ObjectPool<Value>::Create(data, size);
+          }
+
+          void destroy(void* object) const override {
+              ObjectPool<Value>::Destroy(static_cast<Value*>(object));
+          }
+      };
+
       /**
        * \brief Wrapper class to manage factories.
+       *
+       * Factories are published in an immutable array, creating an object is one atomic load and no lock.
+       * Registering copies the array under a lock and publishes the copy, retired arrays are kept until exit
+       * since a reader may still be using one. Registration is safe from static initializers of any translation unit.
        */
       class StaticFactoryWrapper {
       public:
           template<class Value, class... Args>
           static unsigned int addFactory(std::function<Value(Args...)> func, Args... args) {
-              factories_.emplace_back(std::make_unique<Factory<Value, Args...>>(func, args...));
-              return factories_.size() - 1;
+              return publish(std::make_unique<Factory<Value, Args...>>(func, args...));
+          }
+
+          /**
+           * \brief Registers a factory building Value(args...) in its ObjectPool.
+           */
+          template<class Value, class... Args>
+          static unsigned int addPooledFactory(Args... args) {
+              return publish(std::make_unique<PooledFactory<Value, Args...>>(args...));
+          }
+
+          /**
+           * \brief Registers a factory building Value(args...) in its ObjectPool and returns a typed handle to it,
+           * for callers creating often enough that the lookup and virtual calls of create<Value>(id) matter.
+           */
+          template<class Value, class... Args>
+          static FactoryRef<Value, Args...> addPooledFactoryRef(Args... args) {
+              auto factory = std::make_unique<PooledFactory<Value, Args...>>(args...);
+              const PooledFactory<Value, Args...>* raw = factory.get();
+              const unsigned int id = publish(std::move(factory));
+              return FactoryRef<Value, Args...>(raw, id);
+          }
+
+          /**
+           * \brief Registers a factory building Value from serialized bytes in its ObjectPool.
+           */
+          template<class Value>
+          static unsigned int addPageObjectFactory() {
+              return publish(std::make_unique<PageObjectFactory<Value>>());
           }
 
           static void* create(unsigned int id) {
-              if (id < factories_.size()) {
-                  return factories_[id]->create();
+              const IFactory* factory = find(id);
+              return factory ? factory->create() : nullptr;
+          }
+
+          /**
+           * \brief Typed create, nullptr if id is unknown or its factory does not build a Value.
+           * Looks the factory up and makes two virtual calls, a FactoryRef does neither.
+           */
+          template<class Value>
+          static Value* create(unsigned int id) {
+              const IFactory* factory = find(id);
+              if (factory && factory->type() == &FactoryType<Value>::Tag) {
+                  return static_cast<const TypedFactory<Value>*>(factory)->make();
               }
               return nullptr;
           }
 
+          /**
+           * \brief Typed createFrom, nullptr if id is unknown, its factory does not build a Value or does not deserialize.
+           */
+          template<class Value>
+          static Value* createFrom(unsigned int id, const void* data, size_t size) {
+              const IFactory* factory = find(id);
+              if (factory && factory->type() == &FactoryType<Value>::Tag) {
+                  return static_cast<const TypedFactory<Value>*>(factory)->makeFrom(data, size);
+              }
+              return nullptr;
+          }
+
+          /**
+           * \brief Destroys an object made by the factory id.
+           */
+          static void destroy(unsigned int id, void* object) {
+              const IFactory* factory = find(id);
+              if (factory) {
+                  factory->destroy(object);
+              }
+          }
+
       private:
-          static std::vector<std::unique_ptr<IFactory>> factories_;
-      };
+          struct Snapshot {
+              size_t Count;
+              std::unique_ptr<IFactory*[]> Factories;
+              /**
+               * \brief The array this one replaced.
+               */
+              const Snapshot* Previous;
+          };
+
+          /**
+           * \brief Constant initialized, it exists before any dynamic initializer runs and is destroyed after them.
+           */
+          struct Registry {
+              std::atomic<const Snapshot*> Published;
+              std::mutex Mutex;
+
+              constexpr Registry() noexcept : Published(nullptr) {}
+              Registry(const Registry&) = delete;
+              Registry& operator=(const Registry&) = delete;
 
-      // Initialize static member
-      std::vector<std::unique_ptr<IFactory>> StaticFactoryWrapper::factories_;
+              ~Registry() {
+                  const Snapshot* snapshot = Published.load(std::memory_order_acquire);
+                  if (snapshot) {
+                      for (size_t i = 0; i < snapshot->Count; i++) {
+                          delete snapshot->Factories[i];
+                      }
+                  }
+                  while (snapshot) {
+                      const Snapshot* previous = snapshot->Previous;
+                      delete snapshot;
+                      snapshot = previous;
+                  }
+              }
+          };
+
+          inline static Registry registry_;
+
+          static const IFactory* find(unsigned int id) noexcept {
+              const Snapshot* snapshot = registry_.Published.load(std::memory_order_acquire);
+              return snapshot && id < snapshot->Count ? snapshot->Factories[id] : nullptr;
+          }
+
+          static unsigned int publish(std::unique_ptr<IFactory> factory) {
+              std::lock_guard<std::mutex> lock(registry_.Mutex);
+              const Snapshot* current = registry_.Published.load(std::memory_order_relaxed);
+              const size_t count = current ? current->Count : 0;
+              Snapshot* next = new Snapshot{ count + 1, std::unique_ptr<IFactory*[]>(new IFactory*[count + 1]), current };
+              for (size_t i = 0; i < count; i++) {
+                  next->Factories[i] = current->Factories[i];
+              }
+              next->Factories[count] = factory.release();
+              registry_.Published.store(next, std::memory_order_release);
+              return static_cast<unsigned int>(count);
+          }
+      };
 }
@@ -0,0 +1,239 @@
+/*****************************************************************//**
+ * \file   LogEvent.h
+ * \brief  Binary log events: call site descriptors, argument encoding and the binary log format.
+ *
+ * An event stores the id of its call site's descriptor, a tick count and the raw bytes of its arguments,
+ * the text is rendered later by the logger's writer or offline by FurrLogDecoder.
+ *
+ * A binary log starts with LogFormat::Magic followed by tagged records in host byte order:
+ * - Calibration: int64 ticks, int64 Unix time in nanoseconds read at the same moment.
+ * - Descriptor: uint32 id, uint8 level, uint8 argument count, one LogArgType per argument,
+ *   uint16 format length, format, uint16 file length, file, uint32 line.
+ * - Event: uint32 descriptor id, int64 ticks, then the arguments packed back to back.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace NuAtlas {
+    enum class LogLevel {
+        Debug,
+        Info,
+        Warning,
+        Error,
+        Critical
+    };
+
+    enum class LogArgType : uint8_t {
+        Bool, Char, I8, U8, I16, U16, I32, U32, I64, U64, F32, F64, Pointer
+    };
+
+    /**
+     * @brief Everything about an event that does not change between calls, stored once per call site.
+     */
+    struct LogEventDescriptor {
+        LogLevel Level;
+        std::vector<LogArgType> Args;
+        /**
+         * @brief Each {} is replaced by the next argument.
+         */
+        std::string Format;
+        std::string File;
+        uint32_t Line;
+    };
+
+    /**
+     * @brief The static state of a FURR_EVENT call site, Id is assigned on its first call.
+     */
+    struct LogEventSite {
+        const LogLevel Level;
+        const char* const File;
+        const uint32_t Line;
+        std::atomic<uint32_t> Id{ 0 };
+
+        constexpr LogEventSite(LogLevel level, const char* file, uint32_t line) noexcept : Level(level), File(file), Line(line) {}
+    };
+
+    namespace LogFormat {
+        constexpr char Magic[8] = { 'F', 'U', 'R', 'R', 'L', 'O', 'G', '1' };
+        constexpr uint8_t Calibration = 'C';
+        constexpr uint8_t Descriptor = 'D';
+        constexpr uint8_t Event = 'E';
+
+        /**
+         * @brief The timestamp of events, the TSC on x86-64 and steady clock nanoseconds elsewhere.
+         * Calibration records map it to wall time.
+         */
+        inline int64_t Ticks() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+            return static_cast<int64_t>(__rdtsc());
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        inline int64_t UnixNanos() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        constexpr size_t ArgSize(LogArgType type) noexcept {
+            switch (type) {
+            case LogArgType::Bool: case LogArgType::Char: case LogArgType::I8: case LogArgType::U8: return 1;
+            case LogArgType::I16: case LogArgType::U16: return 2;
+            case LogArgType::I32: case LogArgType::U32: case LogArgType::F32: return 4;
+            default: return 8;
+            }
+        }
+
+        template<class T>
+        constexpr LogArgType ArgTypeOf() noexcept {
+            if constexpr (std::is_enum_v<T>) return ArgTypeOf<std::underlying_type_t<T>>();
+            else if constexpr (std::is_pointer_v<T>) return LogArgType::Pointer;
+            else if constexpr (std::is_same_v<T, bool>) return LogArgType::Bool;
+            else if constexpr (std::is_same_v<T, char>) return LogArgType::Char;
+            else if constexpr (std::is_floating_point_v<T>) return sizeof(T) == 4 ? LogArgType::F32 : LogArgType::F64;
+            else if constexpr (std::is_signed_v<T>) {
+                return sizeof(T) == 1 ? LogArgType::I8 : sizeof(T) == 2 ? LogArgType::I16 : sizeof(T) == 4 ? LogArgType::I32 : LogArgType::I64;
+            }
+            else return sizeof(T) == 1 ? LogArgType::U8 : sizeof(T) == 2 ? LogArgType::U16 : sizeof(T) == 4 ? LogArgType::U32 : LogArgType::U64;
+        }
+
+        template<class T>
+        constexpr bool IsArg = std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+        /**
+         * @brief Copies an argument as ArgTypeOf<T> encodes it, returns the byte after it.
+         */
+        template<class T>
+        uint8_t* PackArg(uint8_t* out, const T& value) noexcept {
+            if constexpr (std::is_enum_v<T>) {
+                return PackArg(out, static_cast<std::underlying_type_t<T>>(value));
+            }
+            else if constexpr (std::is_pointer_v<T>) {
+                const uint64_t address = reinterpret_cast<uintptr_t>(value);
+                std::memcpy(out, &address, sizeof(address));
+                return out + sizeof(address);
+            }
+            else if constexpr (std::is_same_v<T, long double>) {
+                return PackArg(out, static_cast<double>(value));
+            }
+            else {
+                std::memcpy(out, &value, sizeof(T));
+                return out + sizeof(T);
+            }
+        }
+
+        template<class T>
+        void AppendNumber(std::string& out, const uint8_t* bytes) {
+            T value;
+            std::memcpy(&value, bytes, sizeof(T));
+            char buf[32];
+            if constexpr (std::is_floating_point_v<T>) {
+                const int written = std::snprintf(buf, sizeof(buf), "%g", static_cast<double>(value));
+                out.append(buf, written > 0 ? static_cast<size_t>(written) : 0);
+            }
+            else {
+                out.append(buf, static_cast<size_t>(std::to_chars(buf, buf + sizeof(buf), value).ptr - buf));
+            }
+        }
+
+        inline void AppendArg(std::string& out, LogArgType type, const uint8_t* bytes) {
+            switch (type) {
+            case LogArgType::Bool: out += bytes[0] ? "true" : "false"; break;
+            case LogArgType::Char: out += static_cast<char>(bytes[0]); break;
+            case LogArgType::I8: AppendNumber<int8_t>(out, bytes); break;
+            case LogArgType::U8: AppendNumber<uint8_t>(out, bytes); break;
+            case LogArgType::I16: AppendNumber<int16_t>(out, bytes); break;
+            case LogArgType::U16: AppendNumber<uint16_t>(out, bytes); break;
+            case LogArgType::I32: AppendNumber<int32_t>(out, bytes); break;
+            case LogArgType::U32: AppendNumber<uint32_t>(out, bytes); break;
+            case LogArgType::I64: AppendNumber<int64_t>(out, bytes); break;
+            case LogArgType::U64: AppendNumber<uint64_t>(out, bytes); break;
+            case LogArgType::F32: AppendNumber<float>(out, bytes); break;
+            case LogArgType::F64: AppendNumber<double>(out, bytes); break;
+            case LogArgType::Pointer: {
+                uint64_t address;
+                std::memcpy(&address, bytes, sizeof(address));
+                char buf[20];
+                buf[0] = '0';
+                buf[1] = 'x';
+                out.append(buf, static_cast<size_t>(std::to_chars(buf + 2, buf + sizeof(buf), address, 16).ptr - buf));
+                break;
+            }
+            }
+        }
+
+        /**
+         * @brief Payload size of a descriptor's arguments.
+         */
+        inline size_t PayloadSize(const LogEventDescriptor& descriptor) noexcept {
+            size_t size = 0;
+            for (const LogArgType type : descriptor.Args) {
+                size += ArgSize(type);
+            }
+            return size;
+        }
+
+        /**
+         * @brief Renders an event's text, arguments without a {} left are dropped.
+         */
+        inline void AppendEvent(std::string& out, const LogEventDescriptor& descriptor, const uint8_t* payload) {
+            size_t arg = 0;
+            const std::string& format = descriptor.Format;
+            for (size_t i = 0; i < format.size(); i++) {
+                if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}' && arg < descriptor.Args.size()) {
+                    AppendArg(out, descriptor.Args[arg], payload);
+                    payload += ArgSize(descriptor.Args[arg]);
+                    arg++;
+                    i++;
+                }
+                else {
+                    out += format[i];
+                }
+            }
+        }
+
+        template<class T>
+        void Put(std::string& out, const T& value) {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        inline void PutCalibration(std::string& out) {
+            Put(out, Calibration);
+            Put(out, Ticks());
+            Put(out, UnixNanos());
+        }
+
+        inline void PutDescriptor(std::string& out, uint32_t id, const LogEventDescriptor& descriptor) {
+            Put(out, Descriptor);
+            Put(out, id);
+            Put(out, static_cast<uint8_t>(descriptor.Level));
+            Put(out, static_cast<uint8_t>(descriptor.Args.size()));
+            out.append(reinterpret_cast<const char*>(descriptor.Args.data()), descriptor.Args.size());
+            Put(out, static_cast<uint16_t>(descriptor.Format.size()));
+            out += descriptor.Format;
+            Put(out, static_cast<uint16_t>(descriptor.File.size()));
+            out += descriptor.File;
+            Put(out, descriptor.Line);
+        }
+    }
+}
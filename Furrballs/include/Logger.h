@@ -1,29 +1,179 @@
 /*****************************************************************//**
  * \file   Logger.h
  * \brief  Logger for Furrballs.
- * 
+ *
+ * Logging is asynchronous by default: callers copy their message into a fixed-size record of a ring owned by
+ * their thread, a background thread formats the records of every ring and writes them in batches.
+ * A full ring drops the record instead of blocking the caller.
+ *
+ * The FURR_LOG_* macros are the cheap way to log: calls below FURR_LOG_LEVEL are compiled out, and the arguments
+ * of the others are only evaluated and formatted if the runtime level lets the message through.
+ * FURR_EVENT_* calls skip formatting altogether, see LogEvent.h. Their records hold raw arguments and are rendered
+ * by the writer, or written as is to the binary output for FurrLogDecoder.
+ *
  * \author The Sphynx
  * \date   July 2024
  *********************************************************************/
+#pragma once
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <ctime>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <initializer_list>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "LogEvent.h"
+
+/**
+ * @brief Lowest level compiled in, 0 (Debug) to 4 (Critical), 5 compiles every FURR_LOG_* call out.
+ * Debug logs are compiled out of release builds unless it is set.
+ */
+#ifndef FURR_LOG_LEVEL
+#ifdef NDEBUG
+#define FURR_LOG_LEVEL 1
+#else
+#define FURR_LOG_LEVEL 0
+#endif
+#endif
+
+/**
+ * @brief Logs the concatenation of its arguments, e.g. FURR_LOG_ERROR("Failed to open DB: ", status.ToString()).
+ * Arguments are strings, characters, booleans or numbers, they are not evaluated if the message is filtered out.
+ */
+#define FURR_LOG(level, ...) \
+    do { \
+        if constexpr (static_cast<int>(level) >= FURR_LOG_LEVEL) { \
+            ::NuAtlas::Logger& furrLogger = ::NuAtlas::Logger::getInstance(); \
+            if (furrLogger.isEnabled(level)) { \
+                furrLogger.logArgs(level, __VA_ARGS__); \
+            } \
+        } \
+    } while (false)
+#define FURR_LOG_DEBUG(...) FURR_LOG(::NuAtlas::LogLevel::Debug, __VA_ARGS__)
+#define FURR_LOG_INFO(...) FURR_LOG(::NuAtlas::LogLevel::Info, __VA_ARGS__)
+#define FURR_LOG_WARNING(...) FURR_LOG(::NuAtlas::LogLevel::Warning, __VA_ARGS__)
+#define FURR_LOG_ERROR(...) FURR_LOG(::NuAtlas::LogLevel::Error, __VA_ARGS__)
+#define FURR_LOG_CRITICAL(...) FURR_LOG(::NuAtlas::LogLevel::Critical, __VA_ARGS__)
+
+/**
+ * @brief Logs a binary event, e.g. FURR_EVENT_DEBUG("Loaded page {} in {} bytes", page, size).
+ * The format must be a string literal, arguments are numbers, characters, booleans, enums or pointers.
+ */
+#define FURR_EVENT(level, ...) \
+    do { \
+        if constexpr (static_cast<int>(level) >= FURR_LOG_LEVEL) { \
+            static ::NuAtlas::LogEventSite furrSite{ level, __FILE__, __LINE__ }; \
+            ::NuAtlas::Logger& furrLogger = ::NuAtlas::Logger::getInstance(); \
+            if (furrLogger.isEnabled(level)) { \
+                furrLogger.logEvent(furrSite, __VA_ARGS__); \
+            } \
+        } \
+    } while (false)
+#define FURR_EVENT_DEBUG(...) FURR_EVENT(::NuAtlas::LogLevel::Debug, __VA_ARGS__)
+#define FURR_EVENT_INFO(...) FURR_EVENT(::NuAtlas::LogLevel::Info, __VA_ARGS__)
+#define FURR_EVENT_WARNING(...) FURR_EVENT(::NuAtlas::LogLevel::Warning, __VA_ARGS__)
+#define FURR_EVENT_ERROR(...) FURR_EVENT(::NuAtlas::LogLevel::Error, __VA_ARGS__)
+#define FURR_EVENT_CRITICAL(...) FURR_EVENT(::NuAtlas::LogLevel::Critical, __VA_ARGS__)
 
 namespace NuAtlas{
-    enum class LogLevel {
-        Debug,
-        Info,
-        Warning,
-        Error,
-        Critical
-    };
     /**
      * @brief Basic Logger.
      */
     class Logger {
     private:
+        /**
+         * @brief A message waiting in a ring, longer messages are truncated.
+         * Events hold their descriptor id, ticks instead of seconds and their packed arguments instead of text.
+         */
+        struct Record {
+            static constexpr size_t TextSize = 232;
+            int64_t Time;
+            uint32_t Event;
+            LogLevel Level;
+            uint16_t Length;
+            char Text[TextSize];
+        };
+
+        /**
+         * @brief Single producer single consumer ring of one thread's records.
+         */
+        struct Ring {
+            static constexpr size_t Capacity = 512;
+            std::unique_ptr<Record[]> Records{ new Record[Capacity] };
+            alignas(64) std::atomic<size_t> Head{ 0 };
+            alignas(64) std::atomic<size_t> Tail{ 0 };
+            /**
+             * @brief The producer's last look at Head, it only reloads it when the ring seems full.
+             */
+            size_t CachedHead = 0;
+            std::atomic<size_t> Dropped{ 0 };
+            /**
+             * @brief Set when the owning thread exits, the ring is released once drained.
+             */
+            std::atomic<bool> Retired{ false };
+        };
+
+        /**
+         * @brief Formats arguments straight into a record sized buffer, the rest of a longer message is cut.
+         */
+        class MessageWriter {
+        public:
+            char Text[Record::TextSize];
+            size_t Length = 0;
+
+            void append(const char* text, size_t length) noexcept {
+                const size_t room = Record::TextSize - Length;
+                length = length < room ? length : room;
+                std::memcpy(Text + Length, text, length);
+                Length += length;
+            }
+            void append(std::string_view text) noexcept { append(text.data(), text.size()); }
+            void append(const char* text) noexcept { append(std::string_view(text)); }
+            void append(const std::string& text) noexcept { append(text.data(), text.size()); }
+            void append(char c) noexcept { append(&c, 1); }
+            void append(bool value) noexcept { append(value ? std::string_view("true") : std::string_view("false")); }
+            template<class T>
+            std::enable_if_t<std::is_arithmetic_v<T>> append(T value) noexcept {
+                char buf[32];
+                if constexpr (std::is_floating_point_v<T>) {
+                    const int written = std::snprintf(buf, sizeof(buf), "%g", static_cast<double>(value));
+                    append(buf, written > 0 ? static_cast<size_t>(written) : 0);
+                }
+                else {
+                    append(buf, static_cast<size_t>(std::to_chars(buf, buf + sizeof(buf), value).ptr - buf));
+                }
+            }
+            template<class T>
+            void append(const T* pointer) noexcept {
+                char buf[20];
+                const int written = std::snprintf(buf, sizeof(buf), "%p", static_cast<const void*>(pointer));
+                append(buf, written > 0 ? static_cast<size_t>(written) : 0);
+            }
+        };
+
+        /**
+         * @brief Registers the ring of a thread on its first message and retires it when the thread exits.
+         */
+        struct RingHandle {
+            std::shared_ptr<Ring> ring;
+            explicit RingHandle(Logger& logger) : ring(std::make_shared<Ring>()) {
+                std::call_once(logger.writerStarted, [&logger] { logger.writer = std::thread([&logger] { logger.writerLoop(); }); });
+                std::lock_guard<std::mutex> lock(logger.ringsMutex);
+                logger.rings.push_back(ring);
+            }
+            ~RingHandle() { ring->Retired.store(true, std::memory_order_release); }
+        };
+
         Logger() : currentLogLevel(LogLevel::Info), logOutput(&std::cout) {}
 
         // Delete copy constructor and assignment operator to prevent copying
@@ -35,18 +185,128 @@ namespace NuAtlas{
             return instance;
         }
         void setLogLevel(LogLevel level) {
-            currentLogLevel = level;
+            currentLogLevel.store(level, std::memory_order_relaxed);
         }
 
+        /**
+         * @brief Records already logged are written to the previous output first.
+         */
         void setLogOutput(std::ostream* output) {
+            flush();
+            std::lock_guard<std::mutex> lock(outputMutex);
             logOutput = output;
         }
 
+        /**
+         * @brief Switches between the background writer and writing on the caller's thread. true by default.
+         */
+        void setAsync(bool enabled) {
+            if (!enabled) {
+                flush();
+            }
+            async.store(enabled, std::memory_order_release);
+        }
+
+        /**
+         * @brief Returns once every record logged before the call is written.
+         */
+        void flush() {
+            std::unique_lock<std::mutex> lock(writerMutex);
+            if (!writer.joinable()) {
+                return;
+            }
+            const uint64_t request = ++flushRequested;
+            writerWake.notify_one();
+            flushed.wait(lock, [&] { return flushCompleted >= request; });
+        }
+
+        /**
+         * @brief Writes events in the binary format of LogEvent.h to output instead of rendering them, nullptr to stop.
+         * Events already logged go to the previous output first.
+         */
+        void setBinaryOutput(std::ostream* output) {
+            flush();
+            std::lock_guard<std::mutex> lock(outputMutex);
+            binaryOutput = output;
+            binaryDescriptors = 0;
+            if (output) {
+                std::string header(LogFormat::Magic, sizeof(LogFormat::Magic));
+                LogFormat::PutCalibration(header);
+                output->write(header.data(), static_cast<std::streamsize>(header.size()));
+                output->flush();
+            }
+        }
+
+        /**
+         * @return The number of records dropped because their ring was full.
+         */
+        size_t getDroppedCount() const noexcept {
+            return dropped.load(std::memory_order_relaxed);
+        }
+
+        bool isEnabled(LogLevel level) const noexcept {
+            return level >= currentLogLevel.load(std::memory_order_relaxed);
+        }
+
         void log(LogLevel level, const std::string& message) {
-            if (level >= currentLogLevel) {
-                std::string logMessage = getCurrentTime() + " [" + logLevelToString(level) + "] " + message;
-                (*logOutput) << logMessage << std::endl;
+            if (isEnabled(level)) {
+                write(level, message.data(), message.size());
+            }
+        }
+
+        /**
+         * @brief Logs the concatenation of args without allocating, use it through the FURR_LOG_* macros.
+         */
+        template<class... Args>
+        void logArgs(LogLevel level, const Args&... args) {
+            if (!isEnabled(level)) {
+                return;
+            }
+            MessageWriter message;
+            (message.append(args), ...);
+            write(level, message.Text, message.Length);
+        }
+
+        /**
+         * @brief Logs an event without formatting it, use it through the FURR_EVENT_* macros.
+         * The site is registered on its first call. Without an async writer the event is rendered at once.
+         */
+        template<class... Args>
+        void logEvent(LogEventSite& site, const char* format, const Args&... args) {
+            static_assert((LogFormat::IsArg<Args> && ...), "Event arguments are numbers, characters, booleans, enums or pointers.");
+            static_assert((size_t(0) + ... + LogFormat::ArgSize(LogFormat::ArgTypeOf<Args>())) <= Record::TextSize,
+                "Event arguments do not fit in a record.");
+            if (!isEnabled(site.Level)) {
+                return;
+            }
+            uint32_t id = site.Id.load(std::memory_order_acquire);
+            if (id == 0) {
+                id = registerEvent(site, format, { LogFormat::ArgTypeOf<Args>()... });
+            }
+            if (!async.load(std::memory_order_acquire)) {
+                uint8_t payload[Record::TextSize] = {};
+                uint8_t* end = payload;
+                ((end = LogFormat::PackArg(end, args)), ...);
+                (void)end;
+                std::string line;
+                {
+                    std::lock_guard<std::mutex> lock(eventsMutex);
+                    appendEventLine(line, static_cast<int64_t>(std::time(nullptr)), id, payload);
+                }
+                std::lock_guard<std::mutex> lock(outputMutex);
+                (*logOutput) << line;
+                logOutput->flush();
+                return;
             }
+            const int64_t ticks = LogFormat::Ticks();
+            push(site.Level, [&](Record& record) {
+                uint8_t* const payload = reinterpret_cast<uint8_t*>(record.Text);
+                uint8_t* end = payload;
+                ((end = LogFormat::PackArg(end, args)), ...);
+                record.Time = ticks;
+                record.Event = id;
+                record.Length = static_cast<uint16_t>(end - payload);
+            });
         }
 
         void debug(const std::string& message) { log(LogLevel::Debug, message); }
@@ -55,18 +315,254 @@ namespace NuAtlas{
         void error(const std::string& message) { log(LogLevel::Error, message); }
         void critical(const std::string& message) { log(LogLevel::Critical, message); }
 
+        ~Logger() {
+            {
+                std::lock_guard<std::mutex> lock(writerMutex);
+                stopping = true;
+            }
+            writerWake.notify_one();
+            if (writer.joinable()) {
+                writer.join();
+            }
+        }
+
     private:
-        LogLevel currentLogLevel;
+        std::atomic<LogLevel> currentLogLevel;
         std::ostream* logOutput;
+        std::atomic<bool> async{ true };
+        std::atomic<size_t> dropped{ 0 };
+        std::atomic<bool> urgent{ false };
+
+        std::mutex ringsMutex;
+        std::vector<std::shared_ptr<Ring>> rings;
+        /**
+         * @brief Held by the writer while it drains, so outputs only change between batches.
+         */
+        std::mutex outputMutex;
+        std::ostream* binaryOutput = nullptr;
+        /**
+         * @brief Descriptors already in the binary output, they are written before their first event.
+         */
+        size_t binaryDescriptors = 0;
+
+        std::mutex eventsMutex;
+        std::vector<LogEventDescriptor> events;
+
+        std::once_flag writerStarted;
+        std::thread writer;
+        std::mutex writerMutex;
+        std::condition_variable writerWake;
+        std::condition_variable flushed;
+        bool stopping = false;
+        uint64_t flushRequested = 0;
+        uint64_t flushCompleted = 0;
+
+        void write(LogLevel level, const char* text, size_t length) {
+            //Lines show seconds, std::time reads a coarse clock several times cheaper than system_clock.
+            const int64_t now = static_cast<int64_t>(std::time(nullptr));
+            if (!async.load(std::memory_order_acquire)) {
+                std::string line;
+                appendLine(line, now, level, text, length);
+                std::lock_guard<std::mutex> lock(outputMutex);
+                (*logOutput) << line;
+                logOutput->flush();
+                return;
+            }
+            push(level, [&](Record& record) {
+                record.Time = now;
+                record.Event = 0;
+                record.Length = static_cast<uint16_t>(length < Record::TextSize ? length : Record::TextSize);
+                std::memcpy(record.Text, text, record.Length);
+            });
+        }
+
+        uint32_t registerEvent(LogEventSite& site, const char* format, std::initializer_list<LogArgType> args) {
+            std::lock_guard<std::mutex> lock(eventsMutex);
+            uint32_t id = site.Id.load(std::memory_order_relaxed);
+            if (id == 0) {
+                events.push_back({ site.Level, std::vector<LogArgType>(args), format, site.File, site.Line });
+                id = static_cast<uint32_t>(events.size());
+                site.Id.store(id, std::memory_order_release);
+            }
+            return id;
+        }
+
+        /**
+         * @brief The calling thread's ring, one per thread whatever it logs so its records stay in order.
+         */
+        Ring& localRing() {
+            thread_local RingHandle handle(*this);
+            return *handle.ring;
+        }
+
+        /**
+         * @brief Fills a record of the calling thread's ring, a few stores and no lock once the ring exists.
+         */
+        template<class Fill>
+        void push(LogLevel level, Fill&& fill) {
+            Ring& ring = localRing();
+            const size_t tail = ring.Tail.load(std::memory_order_relaxed);
+            if (tail - ring.CachedHead == Ring::Capacity) {
+                ring.CachedHead = ring.Head.load(std::memory_order_acquire);
+                if (tail - ring.CachedHead == Ring::Capacity) {
+                    ring.Dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            Record& record = ring.Records[tail % Ring::Capacity];
+            record.Level = level;
+            fill(record);
+            ring.Tail.store(tail + 1, std::memory_order_release);
+            //One wake-up per drain, a burst of errors does not pay for a notify each.
+            if (level >= LogLevel::Error && !urgent.load(std::memory_order_relaxed)
+                && !urgent.exchange(true, std::memory_order_acq_rel)) {
+                //Taking the lock orders the flag before the writer's wait, a writer between its check and its wait is not missed.
+                {
+                    std::lock_guard<std::mutex> lock(writerMutex);
+                }
+                writerWake.notify_one();
+            }
+        }
+
+        /**
+         * @brief Drains every ring every few milliseconds, or at once for errors and flushes.
+         */
+        void writerLoop() {
+            std::string batch;
+            std::string binaryBatch;
+            std::vector<std::shared_ptr<Ring>> snapshot;
+            std::unique_lock<std::mutex> lock(writerMutex);
+            while (true) {
+                writerWake.wait_for(lock, std::chrono::milliseconds(10),
+                    [this] { return stopping || flushRequested != flushCompleted || urgent.load(std::memory_order_relaxed); });
+                const bool stop = stopping;
+                const uint64_t request = flushRequested;
+                lock.unlock();
+                //Records pushed before the flag is cleared are drained below, later errors wake the writer again.
+                urgent.exchange(false, std::memory_order_acq_rel);
+                {
+                    std::lock_guard<std::mutex> ringsLock(ringsMutex);
+                    snapshot = rings;
+                }
+                batch.clear();
+                binaryBatch.clear();
+                {
+                    std::lock_guard<std::mutex> outputLock(outputMutex);
+                    {
+                        std::lock_guard<std::mutex> eventsLock(eventsMutex);
+                        for (const std::shared_ptr<Ring>& ring : snapshot) {
+                            drain(*ring, batch, binaryBatch);
+                        }
+                        if (!binaryBatch.empty()) {
+                            //Descriptors go first so the decoder knows every event it reads.
+                            std::string header;
+                            for (; binaryDescriptors < events.size(); binaryDescriptors++) {
+                                LogFormat::PutDescriptor(header, static_cast<uint32_t>(binaryDescriptors + 1), events[binaryDescriptors]);
+                            }
+                            LogFormat::PutCalibration(header);
+                            binaryBatch.insert(0, header);
+                        }
+                    }
+                    if (!batch.empty()) {
+                        logOutput->write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                        logOutput->flush();
+                    }
+                    if (!binaryBatch.empty()) {
+                        binaryOutput->write(binaryBatch.data(), static_cast<std::streamsize>(binaryBatch.size()));
+                        binaryOutput->flush();
+                    }
+                }
+                releaseRetired();
+                snapshot.clear();
+                lock.lock();
+                flushCompleted = request;
+                flushed.notify_all();
+                if (stop) {
+                    return;
+                }
+            }
+        }
+
+        /**
+         * @brief Called with outputMutex and eventsMutex held.
+         */
+        void drain(Ring& ring, std::string& batch, std::string& binaryBatch) {
+            const size_t lost = ring.Dropped.exchange(0, std::memory_order_relaxed);
+            if (lost) {
+                dropped.fetch_add(lost, std::memory_order_relaxed);
+                const std::string notice = std::to_string(lost) + " log records dropped, a logging thread outpaced the writer.";
+                appendLine(batch, static_cast<int64_t>(std::time(nullptr)), LogLevel::Warning, notice.data(), notice.size());
+            }
+            size_t head = ring.Head.load(std::memory_order_relaxed);
+            const size_t tail = ring.Tail.load(std::memory_order_acquire);
+            for (; head != tail; head++) {
+                const Record& record = ring.Records[head % Ring::Capacity];
+                if (!record.Event) {
+                    appendLine(batch, record.Time, record.Level, record.Text, record.Length);
+                }
+                else if (binaryOutput) {
+                    LogFormat::Put(binaryBatch, LogFormat::Event);
+                    LogFormat::Put(binaryBatch, record.Event);
+                    LogFormat::Put(binaryBatch, record.Time);
+                    binaryBatch.append(record.Text, record.Length);
+                }
+                else {
+                    //Events are at most a few milliseconds old, the drain time is as good as their ticks at a second's resolution.
+                    appendEventLine(batch, static_cast<int64_t>(std::time(nullptr)), record.Event,
+                        reinterpret_cast<const uint8_t*>(record.Text));
+                }
+            }
+            ring.Head.store(head, std::memory_order_release);
+        }
+
+        void releaseRetired() {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for (size_t i = 0; i < rings.size();) {
+                Ring& ring = *rings[i];
+                //Retired before the emptiness check, no record can arrive after it.
+                if (ring.Retired.load(std::memory_order_acquire) && ring.Head.load(std::memory_order_relaxed)
+                    == ring.Tail.load(std::memory_order_acquire) && !ring.Dropped.load(std::memory_order_relaxed)) {
+                    rings[i] = std::move(rings.back());
+                    rings.pop_back();
+                }
+                else {
+                    i++;
+                }
+            }
+        }
+
+        /**
+         * @brief Called with eventsMutex held.
+         */
+        void appendEventLine(std::string& out, int64_t time, uint32_t id, const uint8_t* payload) {
+            const LogEventDescriptor& descriptor = events[id - 1];
+            std::string text;
+            LogFormat::AppendEvent(text, descriptor, payload);
+            appendLine(out, time, descriptor.Level, text.data(), text.size());
+        }
+
+        static void appendLine(std::string& out, int64_t time, LogLevel level, const char* text, size_t length) {
+            out += getTime(static_cast<std::time_t>(time));
+            out += " [";
+            out += logLevelToString(level);
+            out += "] ";
+            out.append(text, length);
+            out += '\n';
+        }
 
-        std::string getCurrentTime() {
-            std::time_t now = std::time(nullptr);
+        static std::string getTime(std::time_t time) {
+            std::tm local{};
+#ifdef _WIN32
+            localtime_s(&local, &time);
+#else
+            localtime_r(&time, &local);
+#endif
             char buf[20];
-            std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+            std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local);
             return buf;
         }
 
-        std::string logLevelToString(LogLevel level) {
+        static const char* logLevelToString(LogLevel level) {
             switch (level) {
             case LogLevel::Debug: return "Debug";
             case LogLevel::Info: return "Info";
@@ -0,0 +1,189 @@
+/*****************************************************************//**
+ * \file   ObjectCache.h
+ * \brief  Objects built once from FurrBall page bytes and kept until their page changes.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <Furrballs.h>
+#include <IFactory.h>
+
+namespace NuAtlas {
+    /**
+     * @brief Caches the Values a factory builds from page bytes, keyed by vAddress.
+     * One object is cached per address, asking for it with another size than it was built from fails.
+     *
+     * Objects are dropped when their page is evicted, released or handed out for writing by FurrBall::Get(),
+     * the next access builds them again from the page. Repeat accesses in between return the built object.
+     * Read the bytes of cached objects through the cache or GetReadOnly(), a Get() on their page invalidates them.
+     * An object may be rebuilt between Get() and the write through its pointer, writers call FurrBall::MarkDirty()
+     * once the write is done so the stale object is dropped.
+     * Objects dropped by the ball are released by the next Get() or Clear() or the cache's destructor, never while
+     * the ball holds its locks, so Value destructors may call back into the ball.
+     */
+    template<class Value>
+    class ObjectCache final {
+    public:
+        using Handle = std::shared_ptr<const Value>;
+
+        /**
+         * @param ball The ball holding the serialized objects, it must outlive the cache.
+         * @param factoryId A StaticFactoryWrapper id building Value from bytes, see addPageObjectFactory.
+         */
+        ObjectCache(FurrBall* ball, unsigned int factoryId) noexcept
+            : Ball(ball), FactoryId(factoryId), PageMask(~(ball->GetPageSize() - 1)) {
+            ListenerId = Ball->AddPageListener([this](size_t pageAddress) { Invalidate(pageAddress); });
+        }
+        ObjectCache(const ObjectCache&) = delete;
+        ObjectCache& operator=(const ObjectCache&) = delete;
+
+        /**
+         * @brief Returns the object serialized at vAddress, building it on the first access since its page changed.
+         * @param size Size of the serialized object, it must not cross a page boundary.
+         * @returns nullptr if the page cannot be read, the bytes cross a page, the factory does not build a Value,
+         * the object at vAddress is cached with another size or the page kept changing while it was built. The handle keeps the object alive after it is invalidated.
+         */
+        Handle Get(void* vAddress, size_t size) noexcept {
+            const size_t address = reinterpret_cast<size_t>(vAddress);
+            const size_t pageAddress = address & PageMask;
+            if (!size || address - pageAddress + size > Ball->GetPageSize()) {
+                return nullptr;
+            }
+            uint64_t epoch;
+            {
+                //Declared before the lock, released after it.
+                std::vector<Handle> retired;
+                std::lock_guard<std::mutex> lock(Mutex);
+                retired.swap(Retired);
+                auto found = Objects.find(address);
+                if (found != Objects.end()) {
+                    return found->second.Size == size ? found->second.Object : nullptr;
+                }
+                PageEntry& page = Pages[pageAddress];
+                page.Building++;
+                epoch = page.Epoch;
+            }
+            //Built outside the lock, an invalidation meanwhile means the bytes may have changed under the factory.
+            for (size_t attempt = 0; ; attempt++) {
+                const void* bytes = Ball->GetReadOnly(vAddress);
+                Value* object = bytes ? StaticFactoryWrapper::createFrom<Value>(FactoryId, bytes, size) : nullptr;
+                Handle handle;
+                if (object) {
+                    const unsigned int factoryId = FactoryId;
+                    handle = Handle(object, [factoryId](const Value* built) {
+                        StaticFactoryWrapper::destroy(factoryId, const_cast<Value*>(built));
+                    });
+                }
+                std::lock_guard<std::mutex> lock(Mutex);
+                PageEntry& page = Pages[pageAddress];
+                if (handle && page.Epoch != epoch && attempt < MaxRebuilds) {
+                    epoch = page.Epoch;
+                    continue;
+                }
+                page.Building--;
+                if (handle && page.Epoch == epoch) {
+                    auto [it, inserted] = Objects.emplace(address, Entry{ handle, size });
+                    if (inserted) {
+                        page.Keys.push_back(address);
+                    }
+                    //Another thread cached it first, maybe from another size.
+                    return it->second.Size == size ? it->second.Object : nullptr;
+                }
+                //The frame may have been reused for another page meanwhile, what was built cannot be trusted.
+                if (page.Keys.empty() && !page.Building) {
+                    Pages.erase(pageAddress);
+                }
+                return nullptr;
+            }
+        }
+
+        /**
+         * @brief Drops every cached object.
+         */
+        void Clear() noexcept {
+            std::vector<Handle> dropped;
+            std::lock_guard<std::mutex> lock(Mutex);
+            dropped.swap(Retired);
+            for (auto& [address, entry] : Objects) {
+                dropped.push_back(std::move(entry.Object));
+            }
+            Objects.clear();
+            for (auto it = Pages.begin(); it != Pages.end();) {
+                it->second.Keys.clear();
+                it->second.Epoch++;
+                it = it->second.Building ? std::next(it) : Pages.erase(it);
+            }
+        }
+
+        size_t Size() const noexcept {
+            std::lock_guard<std::mutex> lock(Mutex);
+            return Objects.size();
+        }
+
+        ~ObjectCache() {
+            Ball->RemovePageListener(ListenerId);
+        }
+
+    private:
+        struct Entry {
+            Handle Object;
+            /**
+             * @brief Size of the bytes the object was built from.
+             */
+            size_t Size;
+        };
+
+        struct PageEntry {
+            /**
+             * @brief Bumped by every invalidation, a build started before it is not cached.
+             */
+            uint64_t Epoch = 0;
+            size_t Building = 0;
+            std::vector<size_t> Keys;
+        };
+
+        static constexpr size_t MaxRebuilds = 3;
+
+        FurrBall* Ball;
+        const unsigned int FactoryId;
+        const size_t PageMask;
+        size_t ListenerId = 0;
+        mutable std::mutex Mutex;
+        std::unordered_map<size_t, Entry> Objects;
+        /**
+         * @brief Pages with cached objects or builds in flight.
+         */
+        std::unordered_map<size_t, PageEntry> Pages;
+        /**
+         * @brief Handles dropped by Invalidate, released outside of it since the ball calls it with its page table locked.
+         */
+        std::vector<Handle> Retired;
+
+        /**
+         * @brief Page listener, called by the ball with its page table locked.
+         */
+        void Invalidate(size_t pageAddress) noexcept {
+            std::lock_guard<std::mutex> lock(Mutex);
+            auto found = Pages.find(pageAddress);
+            if (found == Pages.end()) {
+                return;
+            }
+            PageEntry& page = found->second;
+            for (const size_t address : page.Keys) {
+                auto object = Objects.find(address);
+                Retired.push_back(std::move(object->second.Object));
+                Objects.erase(object);
+            }
+            page.Keys.clear();
+            page.Epoch++;
+            if (!page.Building) {
+                Pages.erase(found);
+            }
+        }
+    };
+}
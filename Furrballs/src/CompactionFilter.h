@@ -0,0 +1,165 @@
+/*****************************************************************//**
+ * \file   CompactionFilter.h
+ * \brief  Compaction filter dropping dead and expired pages.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <new>
+#include <rocksdb/compaction_filter.h>
+#include "Furrballs.h"
+#include "PageFormat.h"
+
+namespace NuAtlas {
+    /**
+     * @brief Bitmap of pages whose stored copy is dead.
+     *
+     * A stored copy is dead when the page was released, or when a volatile ball holds a newer copy in a frame.
+     * Reads are lock-free so compaction threads can query it while the ball mutates it,
+     * chunks are allocated lazily through MemoryManager and never moved.
+     */
+    class PageLiveness final {
+    private:
+        static constexpr size_t WordsPerChunk = 512; //4KB of bits per chunk.
+        static constexpr size_t PagesPerChunk = WordsPerChunk * 64;
+        static constexpr size_t MaxChunks = 4096;
+
+        std::array<std::atomic<std::atomic<uint64_t>*>, MaxChunks> Chunks{};
+        std::mutex GrowMutex;
+
+        std::atomic<uint64_t>* chunkFor(size_t pageIndex, bool create) noexcept {
+            const size_t chunkIndex = pageIndex / PagesPerChunk;
+            if (chunkIndex >= MaxChunks) {
+                return nullptr;
+            }
+            std::atomic<uint64_t>* chunk = Chunks[chunkIndex].load(std::memory_order_acquire);
+            if (chunk || !create) {
+                return chunk;
+            }
+            std::lock_guard<std::mutex> lock(GrowMutex);
+            chunk = Chunks[chunkIndex].load(std::memory_order_relaxed);
+            if (!chunk) {
+                void* memory = MemoryManager::AllocateMemory(WordsPerChunk * sizeof(std::atomic<uint64_t>));
+                if (!memory) {
+                    return nullptr;
+                }
+                chunk = new (memory) std::atomic<uint64_t>[WordsPerChunk]();
+                Chunks[chunkIndex].store(chunk, std::memory_order_release);
+            }
+            return chunk;
+        }
+
+    public:
+        PageLiveness() = default;
+        PageLiveness(const PageLiveness&) = delete;
+        PageLiveness& operator=(const PageLiveness&) = delete;
+
+        /**
+         * @return false if the bitmap could not grow to hold the page.
+         */
+        bool MarkDead(size_t pageIndex) noexcept {
+            std::atomic<uint64_t>* chunk = chunkFor(pageIndex, true);
+            if (!chunk) {
+                return false;
+            }
+            const size_t bit = pageIndex % PagesPerChunk;
+            chunk[bit / 64].fetch_or(uint64_t(1) << (bit % 64), std::memory_order_release);
+            return true;
+        }
+
+        void MarkLive(size_t pageIndex) noexcept {
+            std::atomic<uint64_t>* chunk = chunkFor(pageIndex, false);
+            if (chunk) {
+                const size_t bit = pageIndex % PagesPerChunk;
+                chunk[bit / 64].fetch_and(~(uint64_t(1) << (bit % 64)), std::memory_order_release);
+            }
+        }
+
+        bool IsDead(size_t pageIndex) const noexcept {
+            const size_t chunkIndex = pageIndex / PagesPerChunk;
+            if (chunkIndex >= MaxChunks) {
+                return false;
+            }
+            const std::atomic<uint64_t>* chunk = Chunks[chunkIndex].load(std::memory_order_acquire);
+            if (!chunk) {
+                return false;
+            }
+            const size_t bit = pageIndex % PagesPerChunk;
+            return (chunk[bit / 64].load(std::memory_order_acquire) >> (bit % 64)) & 1;
+        }
+
+        /**
+         * @brief Calls fn(pageIndex) for every dead page.
+         */
+        template<class Fn>
+        void ForEachDead(Fn&& fn) const {
+            for (size_t c = 0; c < MaxChunks; c++) {
+                const std::atomic<uint64_t>* chunk = Chunks[c].load(std::memory_order_acquire);
+                if (!chunk) {
+                    continue;
+                }
+                for (size_t w = 0; w < WordsPerChunk; w++) {
+                    uint64_t word = chunk[w].load(std::memory_order_acquire);
+                    for (size_t b = 0; word; b++, word >>= 1) {
+                        if (word & 1) {
+                            fn(c * PagesPerChunk + w * 64 + b);
+                        }
+                    }
+                }
+            }
+        }
+
+        ~PageLiveness() {
+            for (auto& slot : Chunks) {
+                std::atomic<uint64_t>* chunk = slot.load(std::memory_order_relaxed);
+                if (chunk) {
+                    MemoryManager::FreeMemory(chunk);
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief Drops pages whose stored copy is dead or expired while RocksDB compacts them,
+     * so neither needs a delete tombstone.
+     *
+     * Keys that are not page keys are always kept.
+     */
+    class FurrCompactionFilter final : public rocksdb::CompactionFilter {
+    private:
+        const PageLiveness& Liveness;
+        const size_t PageSize;
+
+    public:
+        FurrCompactionFilter(const PageLiveness& liveness, size_t pageSize) noexcept
+            : Liveness(liveness), PageSize(pageSize) {}
+
+        bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existingValue,
+            std::string* newValue, bool* valueChanged) const override {
+            if (key.size() != PageKeySize) {
+                return false;
+            }
+            if (Liveness.IsDead(DecodePageKey(key) / PageSize)) {
+                return true;
+            }
+            PageRecordHeader header;
+            return DecodeRecordHeader(existingValue, header) && IsExpired(header, NowSeconds());
+        }
+
+        /**
+         * @brief Decides on blob values from their key, so compaction does not read large data blobs only to keep them.
+         */
+        Decision FilterBlobByKey(int level, const rocksdb::Slice& key, std::string* newValue,
+            std::string* skipUntil) const override {
+            return key.size() != PageKeySize ? Decision::kKeep : Decision::kUndetermined;
+        }
+
+        const char* Name() const override {
+            return "FurrCompactionFilter";
+        }
+    };
+}
@@ -7,73 +7,1381 @@
 
 #include "Furrballs.h"
 #include <string_view>
+#include <cstring>
+#include <new>
+#include <condition_variable>
+#include <unordered_set>
 #include <rocksdb/db.h>
+#include <rocksdb/env.h>
 #include <rocksdb/advanced_options.h>
+#include <rocksdb/write_batch.h>
+#include <rocksdb/rate_limiter.h>
+#include <rocksdb/table.h>
+#include <rocksdb/filter_policy.h>
+#include "PageFormat.h"
+#include "CompactionFilter.h"
+#include "Statistics.h"
+#include "PageCodec.h"
+#include "PageFilter.h"
+#include "WorkStealingPool.h"
+#include "ThreadPolicy.h"
 
 using namespace NuAtlas;
 
-struct ::NuAtlas::FurrBall::ImplDetail{
+namespace {
+    constexpr int LZ4HCMaxLevel = 12;
+    constexpr int LZ4HCDefaultLevel = 9;
+
+    /**
+     * @brief Passes the affinity mask of a worker class to an external executor.
+     */
+    class AffinityHint final : public IExecutor {
+    private:
+        IExecutor* Target;
+        uint64_t Mask;
+
+    public:
+        AffinityHint(IExecutor* target, uint64_t mask) noexcept : Target(target), Mask(mask) {}
+
+        void Submit(Task task, TaskPriority priority, uint64_t affinityMask) override {
+            Target->Submit(std::move(task), priority, affinityMask ? affinityMask : Mask);
+        }
+
+        void SubmitBatch(Task* tasks, size_t count, TaskPriority priority, uint64_t affinityMask) override {
+            Target->SubmitBatch(tasks, count, priority, affinityMask ? affinityMask : Mask);
+        }
+
+        bool RunPendingTask() override { return Target->RunPendingTask(); }
+
+        size_t GetConcurrency() const noexcept override {
+            return (std::min)(Target->GetConcurrency(), CoreCount({ Mask }, Target->GetConcurrency()));
+        }
+    };
+
+    /**
+     * @brief Per-thread page buffer that misses read into outside the page table lock.
+     */
+    char* MissStaging(size_t pageSize) noexcept {
+        thread_local std::unique_ptr<char[]> buffer;
+        thread_local size_t size = 0;
+        if (size < pageSize) {
+            buffer.reset(new (std::nothrow) char[pageSize]);
+            size = buffer ? pageSize : 0;
+        }
+        return buffer.get();
+    }
+
+    void WarnIfNotApplied(bool applied) noexcept {
+        if (!applied) {
+            FURR_LOG_WARNING("Could not apply the thread policy of a worker.");
+        }
+    }
+
+    rocksdb::CompressionType ToCompressionType(FurrCompression compression) noexcept {
+        switch (compression) {
+        case FurrCompression::LZ4: return rocksdb::kLZ4Compression;
+        case FurrCompression::LZ4HC: return rocksdb::kLZ4HCCompression;
+        case FurrCompression::ZSTD: return rocksdb::kZSTD;
+        default: return rocksdb::kNoCompression;
+        }
+    }
+}
+
+struct NuAtlas::FurrBall::ImplDetail{
     rocksdb::DB* db = nullptr;
+    /**
+     * @brief Backing Env of a VolatileInMemory ball, must outlive db.
+     */
+    std::unique_ptr<rocksdb::Env> memEnv;
+    rocksdb::WriteOptions writeOptions;
+    rocksdb::ReadOptions readOptions;
+    bool isVolatile = false;
+    /**
+     * @brief Seconds a written page lives before it expires, 0 if pages never expire.
+     */
+    uint64_t PageTTL = 0;
+    size_t PageSize = 0;
+    CodecSettings Codec;
+    /**
+     * @brief Published once trained or loaded, then never replaced: stored pages depend on it.
+     */
+    std::atomic<PageDictionary*> Dictionary{ nullptr };
+    size_t DictionaryBytes = 0;
+    std::mutex DictionaryMutex;
+    char* DictionarySamples = nullptr;
+    size_t DictionarySampleSize = 0;
+    size_t DictionaryCandidates = 0;
+    PageLiveness Liveness;
+    /**
+     * @brief Referenced by the DB options, must outlive db.
+     */
+    std::unique_ptr<FurrCompactionFilter> CompactionFilter;
+    std::shared_ptr<rocksdb::Statistics> statistics;
+    StatCounters Stats;
+    size_t PerfSampleInterval = 0;
+    std::shared_ptr<rocksdb::RateLimiter> rateLimiter;
+    size_t BackgroundBytesPerSecond = 0;
+    size_t CriticalBytesPerSecond = 0;
+    /**
+     * @brief Nesting depth of critical phases, and the depth of the outermost one that paused background work (0 if none).
+     */
+    std::mutex CriticalMutex;
+    size_t CriticalDepth = 0;
+    size_t PausedAtDepth = 0;
+
+    struct ResidentPage {
+        void* Frame = nullptr;
+        bool Dirty = false;
+        /**
+         * @brief Hits since the page was loaded, used to tell hot pages from cold ones.
+         */
+        uint32_t Hits = 0;
+        /**
+         * @brief Packed filter the page is compressed with, see FurrBall::SetPageFilter.
+         */
+        uint8_t Filter = 0;
+    };
+    /**
+     * @brief Pages hit at least this many times while resident are written back as hot.
+     */
+    static constexpr uint32_t HotPageHits = 4;
+    /**
+     * @brief Filter of pages that were never stored with one, from FurrConfig::PageFilter.
+     */
+    uint8_t DefaultFilter = 0;
+    ARCPolicy<size_t, void*> Cache;
+    ARCPolicy<size_t, void*>::EvictionCallback UserEvictionCallback;
+    ARCPolicy<size_t, void*>::BatchEvictionCallback UserBatchEvictionCallback;
+    /**
+     * @brief Listeners by id, guarded by PageTableMutex.
+     */
+    std::vector<std::pair<size_t, std::function<void(size_t)>>> PageListeners;
+    size_t NextPageListener = 1;
+    std::unordered_map<size_t, ResidentPage> PageTable;
+    /**
+     * @brief Frames not holding a page. One more frame than the cache capacity is allocated
+     * so a miss can always load before the policy picks its victim.
+     */
+    std::vector<void*> FreeFrames;
+    void* Slab = nullptr;
+    /**
+     * @brief One past the last page address known to the ball.
+     */
+    size_t Extent = 0;
+    /**
+     * @brief Next handle returned by StoreLargeData, 0 is never a valid handle.
+     */
+    std::atomic<uint64_t> NextLargeDataHandle{ 1 };
+    size_t LargeDataBlockSize = 0;
+    std::mutex PageTableMutex;
+    const size_t Capacity;
+    /**
+     * @brief A page read outside the lock by a miss or a preload, or written back by the reclaimer.
+     * Later misses on it wait for that I/O. While registered, nobody else can make the page resident,
+     * so it cannot be written back under a read nor read before its write back is stored.
+     */
+    struct PendingLoad {
+        std::condition_variable Done;
+        bool Finished = false;
+    };
+    std::unordered_map<size_t, std::shared_ptr<PendingLoad>> PendingLoads;
+
+    /**
+     * @brief Background reclaimer keeping free frames above the low watermark, see FurrConfig::FreeFrameHighWatermark.
+     * Frames of dirty victims are only freed once the batch is stored, misses finding no frame wait for it.
+     * With an external executor passes are tasks instead, ReclaimQueued while one is queued or running.
+     */
+    struct Victim {
+        size_t PageAddress;
+        void* Frame;
+        bool Hot;
+        uint8_t Filter;
+    };
+    std::thread Reclaimer;
+    std::condition_variable ReclaimWake;
+    std::condition_variable FramesFreed;
+    bool StopReclaimer = false;
+    /**
+     * @brief Guarded by PageTableMutex.
+     */
+    bool ReclaimQueued = false;
+    size_t LowWatermark = 0;
+    size_t HighWatermark = 0;
+    /**
+     * @brief Set while the reclaimer demotes pages, OnEvict then hands dirty victims to it instead of writing them.
+     */
+    std::vector<Victim>* ReclaimBatch = nullptr;
+    static constexpr size_t ReclaimBatchSize = 64;
+    /**
+     * @brief Dirty victims of a miss, written back by WriteBackInlineVictims once the lock is dropped. Guarded by PageTableMutex.
+     */
+    std::vector<Victim> InlineVictims;
+
+    /**
+     * @brief Burst mode workers, null unless FurrConfig::EnableBurstMode is set without an executor.
+     * Large data blocks get a pool of their own if FurrConfig::DecompressThreads differs from IOThreads.
+     */
+    std::unique_ptr<WorkStealingPool> Burst;
+    std::unique_ptr<WorkStealingPool> DecodePool;
+    /**
+     * @brief FurrConfig::Executor, wrapped to pass the masks of the worker classes that have one.
+     */
+    IExecutor* External = nullptr;
+    std::unique_ptr<IExecutor> IOHint;
+    std::unique_ptr<IExecutor> DecodeHint;
+    /**
+     * @brief Run page I/O and large data blocks, null outside burst mode.
+     */
+    IExecutor* Executor = nullptr;
+    IExecutor* DecodeExecutor = nullptr;
+    FurrThreadPolicy MaintenancePolicy;
+
+    /**
+     * @brief Low priority thread recompressing cold pages, see FurrConfig::RecompressIntervalSeconds.
+     * With an external executor passes are tasks instead, RecompressQueued while one is queued or running.
+     */
+    std::thread Recompressor;
+    std::mutex RecompressMutex;
+    std::condition_variable RecompressWake;
+    std::atomic<bool> StopRecompressor{ false };
+    std::chrono::seconds RecompressInterval{ 0 };
+    std::atomic<bool> RecompressQueued{ false };
+    std::atomic<std::chrono::steady_clock::rep> NextRecompress{ 0 };
+    /**
+     * @brief Key the next pass resumes from, empty to start over.
+     */
+    std::string RecompressCursor;
+    static constexpr size_t RecompressBatch = 256;
+    /**
+     * @brief The policy's frequent ghosts, copied once per pass instead of searched for every page.
+     */
+    std::unordered_set<size_t> RecompressGhosts;
+
+    ImplDetail(size_t capacity, size_t pageSize) : PageSize(pageSize), Cache(capacity), Capacity(capacity) {}
+
+    /**
+     * @brief Samples one written-back page out of four until enough content is gathered,
+     * then builds the ball's dictionary and stores it.
+     */
+    void SampleForDictionary(const void* frame) noexcept {
+        if (!DictionaryBytes || Dictionary.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(DictionaryMutex);
+        if (Dictionary.load(std::memory_order_relaxed) || DictionaryCandidates++ % 4) {
+            return;
+        }
+        if (!DictionarySamples) {
+            DictionarySamples = static_cast<char*>(MemoryManager::AllocateMemory(DictionaryBytes));
+            if (!DictionarySamples) {
+                return;
+            }
+        }
+        const size_t size = (std::min)(PageSize, DictionaryBytes - DictionarySampleSize);
+        std::memcpy(DictionarySamples + DictionarySampleSize, frame, size);
+        DictionarySampleSize += size;
+        if (DictionarySampleSize < DictionaryBytes) {
+            return;
+        }
+        PageDictionary* dictionary = PageDictionary::Create(DictionarySamples, DictionarySampleSize);
+        MemoryManager::FreeMemory(DictionarySamples);
+        DictionarySamples = nullptr;
+        DictionarySampleSize = 0;
+        if (!dictionary) {
+            FURR_LOG_WARNING("Could not build the page dictionary.");
+            return;
+        }
+        //Stored before use so no page can outlive the dictionary it was compressed with.
+        rocksdb::Status status = db->Put(writeOptions, MetadataKey(PageDictionaryName),
+            rocksdb::Slice(dictionary->GetData(), dictionary->GetSize()));
+        if (!status.ok()) {
+            FURR_LOG_WARNING("Could not store the page dictionary: ", status.ToString());
+            delete dictionary;
+            return;
+        }
+        Dictionary.store(dictionary, std::memory_order_release);
+    }
+
+    /**
+     * @brief Stores an encoded page behind its record header, the stored copy becomes live again.
+     */
+    rocksdb::Status PutPage(size_t pageAddress, const PageRecordHeader& header, const char* data, size_t size,
+        const rocksdb::WriteOptions& options) noexcept {
+        char key[PageKeySize];
+        EncodePageKey(pageAddress, key);
+        char encodedHeader[PageRecordHeaderSize];
+        EncodeRecordHeader(header, encodedHeader);
+        //Header and page are gathered by the batch, the page is not copied into a temporary value.
+        const rocksdb::Slice keySlice(key, PageKeySize);
+        const rocksdb::Slice valueParts[2] = {
+            rocksdb::Slice(encodedHeader, PageRecordHeaderSize),
+            rocksdb::Slice(data, size)
+        };
+        rocksdb::WriteBatch batch;
+        batch.Put(rocksdb::SliceParts(&keySlice, 1), rocksdb::SliceParts(valueParts, 2));
+        rocksdb::Status status = db->Write(options, &batch);
+        if (status.ok()) {
+            Liveness.MarkLive(pageAddress / PageSize);
+        }
+        return status;
+    }
+
+    /**
+     * @brief Compresses and stores a page.
+     * @param hot Whether the page was read often, hot pages favor decode speed over ratio.
+     * @param filter Packed filter of the page, filtered pages are not sampled for the dictionary.
+     */
+    rocksdb::Status WritePage(size_t pageAddress, const void* frame, bool hot, uint8_t filter) noexcept {
+        if (Codec.Compression != FurrCompression::None && !filter) {
+            SampleForDictionary(frame);
+        }
+        const EncodedPage page = EncodePage(frame, PageSize, Codec, hot, Dictionary.load(std::memory_order_acquire), filter);
+        PageRecordHeader header;
+        header.ExpiresAt = PageTTL ? NowSeconds() + PageTTL : 0;
+        header.Codec = static_cast<uint8_t>(page.Codec);
+        header.Filter = filter;
+        return PutPage(pageAddress, header, page.Data, page.Size, writeOptions);
+    }
+
+    /**
+     * @brief Compresses a page into a complete record, for writes gathered in a batch.
+     * Unlike WritePage it does not sample for the dictionary, it may run on any burst worker.
+     */
+    void EncodeRecord(const void* frame, bool hot, uint8_t filter, std::string& record) const {
+        const EncodedPage page = EncodePage(frame, PageSize, Codec, hot, Dictionary.load(std::memory_order_acquire), filter);
+        PageRecordHeader header;
+        header.ExpiresAt = PageTTL ? NowSeconds() + PageTTL : 0;
+        header.Codec = static_cast<uint8_t>(page.Codec);
+        header.Filter = filter;
+        record.resize(PageRecordHeaderSize + page.Size);
+        EncodeRecordHeader(header, &record[0]);
+        std::memcpy(&record[PageRecordHeaderSize], page.Data, page.Size);
+    }
+
+    /**
+     * @brief Makes a frame resident, the policy may evict a victim to make room. PageTableMutex must be held.
+     * @param loaded Whether the frame was read from the stored copy.
+     * @param dirty Whether the page must be written back when evicted.
+     */
+    void AdmitPage(size_t pageAddress, void* frame, uint8_t filter, bool loaded, bool dirty) noexcept {
+        if (loaded && isVolatile) {
+            //The frame now holds the only copy that matters, the stored one is superseded.
+            Liveness.MarkDead(pageAddress / PageSize);
+            dirty = true;
+        }
+        if (pageAddress == Extent) {
+            Extent += PageSize;
+        }
+        PageTable[pageAddress] = { frame, dirty, 0, filter };
+        //May evict, returning the victim's frame to the free pool, dirty victims wait for WriteBackInlineVictims.
+        Cache.add(pageAddress, frame);
+        if (HighWatermark && !External && FreeFrames.size() <= LowWatermark) {
+            ReclaimWake.notify_one();
+        }
+    }
+
+    /**
+     * @brief Tells the page listeners a page no longer holds what they read from it. PageTableMutex must be held.
+     */
+    void InvalidatePage(size_t pageAddress) noexcept {
+        for (const auto& [id, listener] : PageListeners) {
+            listener(pageAddress);
+        }
+    }
+
+    /**
+     * @brief Takes a free frame, waiting for the reclaimer if every free frame is still being written back.
+     */
+    void* TakeFrame(std::unique_lock<std::mutex>& lock) noexcept {
+        FramesFreed.wait(lock, [this] { return !FreeFrames.empty(); });
+        void* frame = FreeFrames.back();
+        FreeFrames.pop_back();
+        return frame;
+    }
+
+    void ReclaimLoop() noexcept {
+        WarnIfNotApplied(ApplyThreadPolicy(MaintenancePolicy));
+        std::unique_lock<std::mutex> lock(PageTableMutex);
+        std::vector<Victim> batch;
+        std::vector<std::string> records;
+        while (true) {
+            ReclaimWake.wait(lock, [this] { return StopReclaimer || FreeFrames.size() <= LowWatermark; });
+            if (StopReclaimer) {
+                return;
+            }
+            ReclaimPass(lock, batch, records);
+        }
+    }
+
+    /**
+     * @brief Evicts pages until HighWatermark frames are free, dirty ones are written back with the lock dropped.
+     * @param lock Holds PageTableMutex, it is held again on return.
+     */
+    void ReclaimPass(std::unique_lock<std::mutex>& lock, std::vector<Victim>& batch, std::vector<std::string>& records) noexcept {
+        const auto start = std::chrono::steady_clock::now();
+        //Demotes in the policy's order, clean victims free their frame right away.
+        batch.clear();
+        ReclaimBatch = &batch;
+        Cache.reclaim((std::min)(HighWatermark - (std::min)(FreeFrames.size(), HighWatermark), ReclaimBatchSize));
+        ReclaimBatch = nullptr;
+        //Live before the lock is dropped, so a release during the write back still wins.
+        for (const Victim& victim : batch) {
+            Liveness.MarkLive(victim.PageAddress / PageSize);
+        }
+        if (!batch.empty()) {
+            lock.unlock();
+            WriteBackVictims(batch, records, Executor);
+            lock.lock();
+            for (const Victim& victim : batch) {
+                FreeFrames.push_back(victim.Frame);
+                FinishLoad(victim.PageAddress);
+            }
+            FramesFreed.notify_all();
+        }
+        Stats.CoreBusy.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+
+    /**
+     * @brief Queues a reclaim pass on the external executor once free frames reach the low watermark and none is queued.
+     * @param lock Holds PageTableMutex, dropped around Submit since an executor may run the pass inline.
+     */
+    void ScheduleReclamation(std::unique_lock<std::mutex>& lock) noexcept {
+        if (!External || !HighWatermark || ReclaimQueued || StopReclaimer || FreeFrames.size() > LowWatermark) {
+            return;
+        }
+        ReclaimQueued = true;
+        lock.unlock();
+        External->Submit([this] {
+            std::vector<Victim> batch;
+            std::vector<std::string> records;
+            std::unique_lock<std::mutex> passLock(PageTableMutex);
+            if (!StopReclaimer) {
+                ReclaimPass(passLock, batch, records);
+            }
+            ReclaimQueued = false;
+        }, TaskPriority::Low, MaintenancePolicy.AffinityMask);
+        lock.lock();
+    }
+
+    /**
+     * @brief Encodes the victims and stores them in one batch.
+     * @param executor Encodes in parallel if not null, only without the lock: a waiting thread may run any queued task.
+     */
+    void WriteBackVictims(const std::vector<Victim>& batch, std::vector<std::string>& records, IExecutor* executor) noexcept {
+        if (Codec.Compression != FurrCompression::None) {
+            for (const Victim& victim : batch) {
+                if (!victim.Filter) {
+                    SampleForDictionary(victim.Frame);
+                }
+            }
+        }
+        records.resize(batch.size());
+        ParallelFor(executor, batch.size(), [&](size_t i) {
+            EncodeRecord(batch[i].Frame, batch[i].Hot, batch[i].Filter, records[i]);
+        });
+        rocksdb::WriteBatch writeBack;
+        for (size_t i = 0; i < batch.size(); i++) {
+            char key[PageKeySize];
+            EncodePageKey(batch[i].PageAddress, key);
+            writeBack.Put(rocksdb::Slice(key, PageKeySize), records[i]);
+        }
+        rocksdb::Status status = db->Write(writeOptions, &writeBack);
+        if (!status.ok()) {
+            FURR_LOG_ERROR("Failed to write back pages: ", status.ToString());
+            return;
+        }
+        Stats.WriteBacks.fetch_add(batch.size(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Writes back the dirty victims of misses with the lock released, as the reclaimer does.
+     * @param lock Holds PageTableMutex, it is held again on return.
+     */
+    void WriteBackInlineVictims(std::unique_lock<std::mutex>& lock) noexcept {
+        if (InlineVictims.empty()) {
+            return;
+        }
+        std::vector<Victim> batch;
+        batch.swap(InlineVictims);
+        //Live before the lock is dropped, so a release during the write back still wins.
+        for (const Victim& victim : batch) {
+            Liveness.MarkLive(victim.PageAddress / PageSize);
+        }
+        thread_local std::vector<std::string> records;
+        lock.unlock();
+        WriteBackVictims(batch, records, Executor);
+        lock.lock();
+        for (const Victim& victim : batch) {
+            FreeFrames.push_back(victim.Frame);
+            FinishLoad(victim.PageAddress);
+        }
+        FramesFreed.notify_all();
+    }
+
+    void StopReclamation() noexcept {
+        std::unique_lock<std::mutex> lock(PageTableMutex);
+        StopReclaimer = true;
+        if (Reclaimer.joinable()) {
+            lock.unlock();
+            ReclaimWake.notify_all();
+            Reclaimer.join();
+            return;
+        }
+        //A queued pass still points at the ball, help it along.
+        while (ReclaimQueued) {
+            lock.unlock();
+            if (!External->RunPendingTask()) {
+                std::this_thread::yield();
+            }
+            lock.lock();
+        }
+    }
+
+    /**
+     * @brief Wakes the misses waiting for the read of pageAddress, whether it was admitted or not. PageTableMutex must be held.
+     */
+    void FinishLoad(size_t pageAddress) noexcept {
+        auto it = PendingLoads.find(pageAddress);
+        if (it == PendingLoads.end()) {
+            return;
+        }
+        it->second->Finished = true;
+        it->second->Done.notify_all();
+        PendingLoads.erase(it);
+    }
+
+    void RecompressLoop() noexcept {
+        WarnIfNotApplied(ApplyThreadPolicy(MaintenancePolicy));
+        void* page = MemoryManager::AllocateMemory(PageSize);
+        if (!page) {
+            FURR_LOG_WARNING("Background recompression could not allocate its page.");
+            return;
+        }
+        std::unique_lock<std::mutex> lock(RecompressMutex);
+        while (!RecompressWake.wait_for(lock, RecompressInterval, [this] { return StopRecompressor.load(); })) {
+            lock.unlock();
+            const auto start = std::chrono::steady_clock::now();
+            RecompressColdPages(page);
+            Stats.CoreBusy.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+            lock.lock();
+        }
+        MemoryManager::FreeMemory(page);
+    }
+
+    /**
+     * @brief Queues a pass on the external executor if the interval elapsed and none is queued.
+     * Called without PageTableMutex, an executor may run the pass inline.
+     */
+    void ScheduleRecompression() noexcept {
+        if (std::chrono::steady_clock::now().time_since_epoch().count() < NextRecompress.load(std::memory_order_relaxed)
+            || RecompressQueued.exchange(true)) {
+            return;
+        }
+        //Either StopRecompression sees the pass queued or the pass is not queued.
+        if (StopRecompressor.load()) {
+            RecompressQueued.store(false);
+            return;
+        }
+        External->Submit([this] {
+            if (!StopRecompressor.load()) {
+                void* page = MemoryManager::AllocateMemory(PageSize);
+                if (page) {
+                    RecompressColdPages(page);
+                    MemoryManager::FreeMemory(page);
+                }
+            }
+            NextRecompress.store((std::chrono::steady_clock::now() + RecompressInterval).time_since_epoch().count(),
+                std::memory_order_relaxed);
+            RecompressQueued.store(false);
+        }, TaskPriority::Low, MaintenancePolicy.AffinityMask);
+    }
+
+    /**
+     * @brief Recompresses the next batch of stored pages, skipped while a critical phase is active.
+     */
+    void RecompressColdPages(void* page) noexcept {
+        {
+            std::lock_guard<std::mutex> lock(CriticalMutex);
+            if (CriticalDepth) {
+                return;
+            }
+        }
+        rocksdb::ReadOptions scanOptions = readOptions;
+        scanOptions.fill_cache = false;
+        //Metadata and large data keys sort after every page, the scan never reaches them or loads their blobs.
+        const rocksdb::Slice upperBound(&MetadataPrefix, 1);
+        scanOptions.iterate_upper_bound = &upperBound;
+        std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(scanOptions));
+        if (RecompressCursor.empty()) {
+            it->SeekToFirst();
+        }
+        else {
+            it->Seek(RecompressCursor);
+        }
+        RecompressGhosts.clear();
+        {
+            std::lock_guard<std::mutex> lock(PageTableMutex);
+            Cache.frequentGhosts(RecompressGhosts);
+        }
+        CodecSettings settings = Codec;
+        settings.Compression = FurrCompression::LZ4HC;
+        settings.HCLevel = Codec.HCLevel > 0 ? Codec.HCLevel : LZ4HCDefaultLevel;
+        for (size_t processed = 0; it->Valid() && processed < RecompressBatch; it->Next()) {
+            if (it->key().size() != PageKeySize) {
+                break;
+            }
+            processed++;
+            RecompressPage(DecodePageKey(it->key()), it->value(), settings, page);
+        }
+        //Past the last page the next pass starts over.
+        RecompressCursor = it->Valid() && it->key().size() == PageKeySize ? it->key().ToString() : std::string();
+    }
+
+    void RecompressPage(size_t pageAddress, const rocksdb::Slice& value, const CodecSettings& settings, void* page) noexcept {
+        PageRecordHeader header;
+        if (!DecodeRecordHeader(value, header) || IsExpired(header, NowSeconds())) {
+            return;
+        }
+        const PageCodec codec = static_cast<PageCodec>(header.Codec);
+        if (codec == PageCodec::LZ4HC || codec == PageCodec::LZ4HCDict) {
+            return;
+        }
+        //Pages recently used more than once are likely to come back.
+        if (RecompressGhosts.count(pageAddress)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(PageTableMutex);
+            //Resident pages get written back anyway, pending pages are being loaded or written back outside the lock.
+            if (PageTable.count(pageAddress) || PendingLoads.count(pageAddress) || Liveness.IsDead(pageAddress / PageSize)) {
+                return;
+            }
+        }
+        const size_t storedSize = value.size() - PageRecordHeaderSize;
+        const PageDictionary* dictionary = Dictionary.load(std::memory_order_acquire);
+        if (!DecodePage(codec, value.data() + PageRecordHeaderSize, storedSize, page, PageSize, dictionary, header.Filter)) {
+            return;
+        }
+        const EncodedPage encoded = EncodePage(page, PageSize, settings, false, dictionary, header.Filter);
+        if (encoded.Codec == PageCodec::Raw || encoded.Size + PageSize / 16 > storedSize) {
+            return;
+        }
+        header.Codec = static_cast<uint8_t>(encoded.Codec);
+        char key[PageKeySize];
+        EncodePageKey(pageAddress, key);
+        {
+            std::lock_guard<std::mutex> lock(PageTableMutex);
+            //A pending write back would be overwritten by an older record.
+            if (PageTable.count(pageAddress) || PendingLoads.count(pageAddress) || Liveness.IsDead(pageAddress / PageSize)) {
+                return;
+            }
+            //Misses on the page wait for the replacement instead of reading the record being replaced.
+            PendingLoads.emplace(pageAddress, std::make_shared<PendingLoad>());
+        }
+        //Only replace the exact version that was recompressed.
+        rocksdb::PinnableSlice current;
+        if (db->Get(readOptions, db->DefaultColumnFamily(), rocksdb::Slice(key, PageKeySize), &current).ok() && current == value) {
+            rocksdb::WriteOptions options = writeOptions;
+            options.low_pri = true;
+            if (PutPage(pageAddress, header, encoded.Data, encoded.Size, options).ok()) {
+                Stats.RecompressedPages.fetch_add(1, std::memory_order_relaxed);
+                Stats.RecompressedBytesSaved.fetch_add(storedSize - encoded.Size, std::memory_order_relaxed);
+            }
+        }
+        std::lock_guard<std::mutex> lock(PageTableMutex);
+        FinishLoad(pageAddress);
+    }
+
+    void StopRecompression() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(RecompressMutex);
+            StopRecompressor = true;
+        }
+        if (Recompressor.joinable()) {
+            RecompressWake.notify_all();
+            Recompressor.join();
+        }
+        //A queued pass still points at the ball, help it along.
+        while (RecompressQueued.load()) {
+            if (!External->RunPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * @brief Pins the encoded large data of handle and reads its size.
+     * @returns false if the handle is unknown or the value is not valid large data.
+     */
+    bool GetLargeData(size_t handle, rocksdb::PinnableSlice& value, size_t& size) noexcept {
+        char key[LargeDataKeySize];
+        EncodeLargeDataKey(handle, key);
+        rocksdb::Status status = db->Get(readOptions, db->DefaultColumnFamily(), rocksdb::Slice(key, LargeDataKeySize), &value);
+        if (!status.ok()) {
+            if (!status.IsNotFound()) {
+                FURR_LOG_ERROR("Failed to load large data: ", status.ToString());
+            }
+            return false;
+        }
+        if (!LargeDataSize(value.data(), value.size(), size)) {
+            FURR_LOG_ERROR("Large data is corrupted.");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Loads a page into frame. Dead and expired pages are reported as NotFound.
+     * @param filter Receives the page's stored filter, left untouched unless the page loads.
+     */
+    rocksdb::Status ReadPage(size_t pageAddress, void* frame, uint8_t& filter) noexcept {
+        if (Liveness.IsDead(pageAddress / PageSize)) {
+            return rocksdb::Status::NotFound();
+        }
+        char key[PageKeySize];
+        EncodePageKey(pageAddress, key);
+        rocksdb::PinnableSlice value;
+        //Covers the decode too, with the ball's page codec the DB itself decompresses nothing.
+        PerfSample sample(Stats, PerfSampleInterval);
+        rocksdb::Status status = db->Get(readOptions, db->DefaultColumnFamily(), rocksdb::Slice(key, PageKeySize), &value);
+        if (!status.ok()) {
+            return status;
+        }
+        PageRecordHeader header;
+        if (!DecodeRecordHeader(value, header)) {
+            return rocksdb::Status::Corruption("Page record is too short");
+        }
+        if (IsExpired(header, NowSeconds())) {
+            return rocksdb::Status::NotFound();
+        }
+        //The value is pinned in the block cache, it decodes into the frame without an intermediate copy.
+        const auto decodeStart = sample.Now();
+        if (!DecodePage(static_cast<PageCodec>(header.Codec), value.data() + PageRecordHeaderSize,
+            value.size() - PageRecordHeaderSize, frame, PageSize, Dictionary.load(std::memory_order_acquire), header.Filter)) {
+            return rocksdb::Status::Corruption("Page failed to decode");
+        }
+        sample.AddDecompressTime(decodeStart);
+        filter = header.Filter;
+        return status;
+    }
+
+    ~ImplDetail() {
+        delete db;
+        db = nullptr;
+        memEnv.reset();
+        if (Slab) {
+            MemoryManager::FreeMemory(Slab);
+        }
+        delete Dictionary.load();
+        if (DictionarySamples) {
+            MemoryManager::FreeMemory(DictionarySamples);
+        }
+    }
 };
 
-NuAtlas::FurrBall::FurrBall(const FurrConfig& config) noexcept : PageSize(config.PageSize),
-    SizeLimit(config.CapacityLimit ? config.CapacityLimit : 1 * 1024 * 1024 * sizeof(char)), DataMembers(new ImplDetail())
+NuAtlas::FurrBall::FurrBall(const FurrConfig& config, size_t numPages) noexcept : DataMembers(new ImplDetail(numPages, config.PageSize)),
+    PageSize(config.PageSize), SizeLimit(config.CapacityLimit ? config.CapacityLimit : 1 * 1024 * 1024 * sizeof(char))
 {
 }
 
-void NuAtlas::FurrBall::OnEvict(size_t key) noexcept
+void NuAtlas::FurrBall::OnEvict(std::pair<size_t, void*>* victims, size_t count) noexcept
 {
+    const bool background = DataMembers->ReclaimBatch != nullptr;
+    std::vector<ImplDetail::Victim>& dirty = background ? *DataMembers->ReclaimBatch : DataMembers->InlineVictims;
+    const size_t firstDirty = dirty.size();
+    size_t freed = 0;
+    for (size_t i = 0; i < count; i++) {
+        const size_t key = victims[i].first;
+        auto it = DataMembers->PageTable.find(key);
+        if (it == DataMembers->PageTable.end()) {
+            continue;
+        }
+        if (it->second.Dirty) {
+            dirty.push_back({ key, it->second.Frame, it->second.Hits >= ImplDetail::HotPageHits, it->second.Filter });
+            //Written back once the lock is dropped, misses on it wait until then.
+            DataMembers->PendingLoads.emplace(key, std::make_shared<ImplDetail::PendingLoad>());
+        }
+        else {
+            DataMembers->FreeFrames.push_back(it->second.Frame);
+        }
+        DataMembers->PageTable.erase(it);
+        DataMembers->InvalidatePage(key);
+        freed++;
+    }
+    DataMembers->Stats.Evictions.fetch_add(freed, std::memory_order_relaxed);
+    FURR_EVENT_DEBUG("Evicted {} pages, {} dirty, in the background {}", freed, dirty.size() - firstDirty, background);
+    if (background) {
+        DataMembers->Stats.BackgroundEvictions.fetch_add(freed, std::memory_order_relaxed);
+    }
+    if (DataMembers->UserBatchEvictionCallback) {
+        DataMembers->UserBatchEvictionCallback(victims, count);
+    }
+    if (DataMembers->UserEvictionCallback) {
+        for (size_t i = 0; i < count; i++) {
+            DataMembers->UserEvictionCallback(victims[i].first);
+        }
+    }
 }
 
 FurrBall* FurrBall::CreateBall(const std::string& DBpath, const FurrConfig& config, bool overwrite) noexcept
 {
-    rocksdb::Options options;
-    rocksdb::DB* db;
-    options.compression = rocksdb::kLZ4Compression;
-    //fb.options.OptimizeForPointLookup();
-    options.create_if_missing = true;
-    rocksdb::Status status =
-        rocksdb::DB::Open(options, DBpath, &db);
-    if (!status.ok()) {
-        //ERR
-        return nullptr;
-    }
     //Setup Cache.
     size_t numPages = config.InitialPageCount;
     size_t availMem = MemoryManager::GetAvailableMemory();
-    if (availMem < config.PageSize * numPages) {
+    if (availMem < config.PageSize * (numPages + 1)) {
         //We don't have enough memory to allocate all the pages.
-        while ((--numPages) || availMem < config.PageSize * numPages);
+        while (numPages > 0 && availMem < config.PageSize * (numPages + 1)) {
+            --numPages;
+        }
         if (numPages <= 0) {
-            Logger::getInstance().error("Not enough memory");
+            FURR_LOG_ERROR("Not enough memory");
             return nullptr;
         }
     }
-    ARCPolicy<size_t, void*> Cache(numPages);
-    //Allocate Slab.
-    char* slab = static_cast<char*>(malloc(config.PageSize * numPages));
+    //Allocate Slab, with one spare frame.
+    char* slab = static_cast<char*>(MemoryManager::AllocateMemory(config.PageSize * (numPages + 1)));
     if (!slab) {
-        Logger::getInstance().warning("Could not allocated memory slab.");
+        FURR_LOG_WARNING("Could not allocated memory slab.");
         //Maybe attempt to allocate fragmented slab.
         //for now return nullptr
         return nullptr;
     }
-    FurrBall* fb = new FurrBall(config);
-    fb->DataMembers->db = db;
+    FurrBall* fb = new FurrBall(config, numPages);
+    ImplDetail* impl = fb->DataMembers;
+    impl->Slab = slab;
+    impl->isVolatile = config.IsVolatile;
+    impl->PageTTL = config.PageTTL;
+    impl->PerfSampleInterval = config.PerfSampleInterval;
+    impl->Codec.Compression = config.PageCompression == FurrCompression::LZ4HC || config.PageCompression == FurrCompression::None ?
+        config.PageCompression : FurrCompression::LZ4;
+    impl->Codec.Acceleration = (std::max)(config.LZ4Acceleration, 1);
+    impl->Codec.HCLevel = (std::min)(config.LZ4HCLevel, LZ4HCMaxLevel);
+    impl->DefaultFilter = PackPageFilter(config.PageFilter, config.PageElementSize);
+    impl->LargeDataBlockSize = (std::min)((std::max)(config.LargeDataBlockSize, MinLargeDataBlockSize), MaxLargeDataBlockSize);
+    impl->DictionaryBytes = (std::min)(config.PageDictionaryBytes, PageDictionary::MaxSize);
+    impl->CompactionFilter = std::make_unique<FurrCompactionFilter>(impl->Liveness, config.PageSize);
+
+    rocksdb::Options options;
+    rocksdb::DB* db;
+    options.compression = ToCompressionType(config.LevelCompression);
+    options.compression_per_level.assign(options.num_levels, ToCompressionType(config.LevelCompression));
+    for (int level = 0; level < 2 && level < options.num_levels; level++) {
+        options.compression_per_level[level] = ToCompressionType(config.HotLevelCompression);
+    }
+    options.bottommost_compression = ToCompressionType(config.BottommostCompression);
+    if (config.CompressionDictionaryBytes && config.BottommostCompression != FurrCompression::None) {
+        options.bottommost_compression_opts.enabled = true;
+        options.bottommost_compression_opts.max_dict_bytes = static_cast<uint32_t>(config.CompressionDictionaryBytes);
+        if (config.BottommostCompression == FurrCompression::ZSTD) {
+            //Train on ~100x the dictionary size of sampled blocks.
+            options.bottommost_compression_opts.zstd_max_train_bytes = static_cast<uint32_t>(config.CompressionDictionaryBytes * 100);
+        }
+    }
+    if (impl->Codec.Compression != FurrCompression::None) {
+        //Pages arrive compressed, block compression would only add a whole-block decompress to every load.
+        options.compression = rocksdb::kNoCompression;
+        options.compression_per_level.assign(options.num_levels, rocksdb::kNoCompression);
+        options.bottommost_compression = rocksdb::kNoCompression;
+        options.bottommost_compression_opts.enabled = false;
+    }
+    //fb.options.OptimizeForPointLookup();
+    options.create_if_missing = true;
+    options.compaction_filter = impl->CompactionFilter.get();
+    if (config.BloomBitsPerKey > 0) {
+        //Page loads are point lookups, the filter spares them the SST files that do not hold the page.
+        rocksdb::BlockBasedTableOptions tableOptions;
+        tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(config.BloomBitsPerKey));
+        options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+    }
+    if (config.EnableStatistics) {
+        impl->statistics = rocksdb::CreateDBStatistics();
+        //Detailed timers are what PerfContext sampling is for, decompression time is in FurrStats::Sampled.
+        impl->statistics->set_stats_level(rocksdb::StatsLevel::kExceptDetailedTimers);
+        options.statistics = impl->statistics;
+    }
+    //Integrated BlobDB: large data lives in blob files, pages stay inline in SSTs.
+    //Large data compressed by the ball is stored as is, a whole-blob codec would defeat its seek table.
+    options.enable_blob_files = true;
+    options.min_blob_size = (std::max)(config.LargeDataThreshold, PageRecordHeaderSize + config.PageSize + 1);
+    options.blob_compression_type = impl->Codec.Compression != FurrCompression::None ?
+        rocksdb::kNoCompression : rocksdb::kLZ4Compression;
+    options.enable_blob_garbage_collection = true;
+    if (config.BackgroundBytesPerSecond) {
+        //Auto-tuned, the limit adapts under the configured bound and only flush/compaction writes are charged.
+        impl->rateLimiter.reset(rocksdb::NewGenericRateLimiter(static_cast<int64_t>(config.BackgroundBytesPerSecond),
+            100 * 1000, 10, rocksdb::RateLimiter::Mode::kWritesOnly, true));
+        impl->BackgroundBytesPerSecond = config.BackgroundBytesPerSecond;
+        //The auto-tuner would raise anything lower back to a twentieth of the bound at its next tuning.
+        impl->CriticalBytesPerSecond = (std::min)((std::max)(config.CriticalBytesPerSecond, config.BackgroundBytesPerSecond / 20),
+            config.BackgroundBytesPerSecond);
+        options.rate_limiter = impl->rateLimiter;
+    }
+    if (config.IsVolatile) {
+        //Scratch data: never fsync, never replay, and let same-size page overwrites update the memtable in place.
+        options.use_fsync = false;
+        options.avoid_flush_during_shutdown = true;
+        options.avoid_flush_during_recovery = true;
+        options.inplace_update_support = true;
+        options.allow_concurrent_memtable_write = false;
+        options.write_buffer_size = 64 * 1024 * 1024;
+        options.max_write_buffer_number = 4;
+        if (config.VolatileInMemory) {
+            impl->memEnv.reset(rocksdb::NewMemEnv(rocksdb::Env::Default()));
+            options.env = impl->memEnv.get();
+        }
+        impl->writeOptions.disableWAL = true;
+        impl->writeOptions.sync = false;
+    }
+    if (config.BackgroundBytesPerSecond) {
+        //Compactions run in the LOW pool, flushes keep their priority so writes never stall behind them.
+        //The pool is Env::Default()'s, shared by the process and never raised back, see FurrConfig::BackgroundBytesPerSecond.
+        options.env->LowerThreadPoolIOPriority(rocksdb::Env::Priority::LOW);
+        options.env->LowerThreadPoolCPUPriority(rocksdb::Env::Priority::LOW);
+    }
+    if (overwrite || config.IsVolatile) {
+        rocksdb::DestroyDB(DBpath, options);
+    }
+    rocksdb::Status status =
+        rocksdb::DB::Open(options, DBpath, &db);
+    if (!status.ok()) {
+        FURR_LOG_ERROR("Failed to open DB: ", status.ToString());
+        delete fb;
+        return nullptr;
+    }
+    impl->db = db;
+    impl->UserEvictionCallback = config.evictionCallback;
+    impl->UserBatchEvictionCallback = config.batchEvictionCallback;
+    impl->Cache.setBatchEvictionCallback([fb](std::pair<size_t, void*>* victims, size_t count) { fb->OnEvict(victims, count); },
+        (std::min)(config.EvictionBatchSize, (std::max)(numPages / 8, size_t(1))));
     size_t PagePointer = 0;
-    for (int i = 0; i < numPages; i++) {
-        Cache.add(PagePointer, slab + PagePointer);
+    for (size_t i = 0; i <= numPages; i++, PagePointer += config.PageSize) {
+        impl->FreeFrames.push_back(slab + PagePointer);
         fb->PageList.push_back((config.LockablePages ? LockablePage(slab + PagePointer, i) : Page(slab + PagePointer, i)));
     }
+    //Restore the page dictionary, the extent and large data handles of a persistent ball.
+    rocksdb::PinnableSlice dictionary;
+    if (db->Get(impl->readOptions, db->DefaultColumnFamily(), MetadataKey(PageDictionaryName), &dictionary).ok()) {
+        impl->Dictionary = PageDictionary::Create(dictionary.data(), dictionary.size());
+        if (!impl->Dictionary.load()) {
+            FURR_LOG_ERROR("Could not load the page dictionary.");
+            delete fb;
+            return nullptr;
+        }
+    }
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(impl->readOptions));
+    it->SeekToLast();
+    if (it->Valid() && IsLargeDataKey(it->key())) {
+        impl->NextLargeDataHandle = DecodeLargeDataKey(it->key()) + 1;
+    }
+    it->SeekForPrev(rocksdb::Slice(&LargeDataPrefix, 1));
+    while (it->Valid() && it->key().size() != PageKeySize) {
+        it->Prev();
+    }
+    if (it->Valid()) {
+        impl->Extent = DecodePageKey(it->key()) + config.PageSize;
+    }
+    impl->MaintenancePolicy = config.MaintenanceThreads;
+    if (config.Executor) {
+        impl->External = config.Executor;
+        impl->Executor = impl->DecodeExecutor = config.Executor;
+        if (config.IOThreads.AffinityMask) {
+            impl->IOHint = std::make_unique<AffinityHint>(config.Executor, config.IOThreads.AffinityMask);
+            impl->Executor = impl->IOHint.get();
+        }
+        if (config.DecompressThreads.AffinityMask) {
+            impl->DecodeHint = std::make_unique<AffinityHint>(config.Executor, config.DecompressThreads.AffinityMask);
+            impl->DecodeExecutor = impl->DecodeHint.get();
+        }
+    }
+    else if (config.EnableBurstMode) {
+        //A mask is a core budget, more workers than its cores would preempt each other.
+        const size_t threads = config.BurrstThreadCount ? config.BurrstThreadCount
+            : (std::max)(std::thread::hardware_concurrency(), 1u);
+        CoreBusyTime* busy = &impl->Stats.CoreBusy;
+        const FurrThreadPolicy io = config.IOThreads;
+        impl->Burst = std::make_unique<WorkStealingPool>(CoreCount(io, threads),
+            [io] { WarnIfNotApplied(ApplyThreadPolicy(io)); }, busy);
+        impl->Executor = impl->DecodeExecutor = impl->Burst.get();
+        if (config.DecompressThreads != config.IOThreads) {
+            const FurrThreadPolicy decode = config.DecompressThreads;
+            impl->DecodePool = std::make_unique<WorkStealingPool>(CoreCount(decode, threads),
+                [decode] { WarnIfNotApplied(ApplyThreadPolicy(decode)); }, busy);
+            impl->DecodeExecutor = impl->DecodePool.get();
+        }
+    }
+    if (config.FreeFrameHighWatermark) {
+        impl->HighWatermark = (std::max)((std::min)(config.FreeFrameHighWatermark, numPages / 2), size_t(1));
+        const size_t low = config.FreeFrameLowWatermark ? config.FreeFrameLowWatermark : impl->HighWatermark / 2;
+        impl->LowWatermark = (std::min)(low, impl->HighWatermark - 1);
+        //With an executor, misses queue reclaim passes on it instead.
+        if (!impl->External) {
+            impl->Reclaimer = std::thread([impl] { impl->ReclaimLoop(); });
+        }
+    }
+    if (config.RecompressIntervalSeconds && impl->Codec.Compression != FurrCompression::None) {
+        impl->RecompressInterval = std::chrono::seconds(config.RecompressIntervalSeconds);
+        if (impl->External) {
+            impl->NextRecompress = (std::chrono::steady_clock::now() + impl->RecompressInterval).time_since_epoch().count();
+        }
+        else {
+            impl->Recompressor = std::thread([impl] { impl->RecompressLoop(); });
+        }
+    }
     return fb;
 }
 
-void NuAtlas::FurrBall::StoreLargeData(void* buffer, size_t size)
+void* NuAtlas::FurrBall::Get(void* vAddress) noexcept
+{
+    return Access(vAddress, true);
+}
+
+const void* NuAtlas::FurrBall::GetReadOnly(void* vAddress) noexcept
+{
+    return Access(vAddress, false);
+}
+
+void NuAtlas::FurrBall::MarkDirty(void* vAddress) noexcept
+{
+    const size_t pageAddress = floorAddress(reinterpret_cast<size_t>(vAddress));
+    std::lock_guard<std::mutex> lock(DataMembers->PageTableMutex);
+    auto it = DataMembers->PageTable.find(pageAddress);
+    if (it != DataMembers->PageTable.end()) {
+        it->second.Dirty = true;
+    }
+    DataMembers->InvalidatePage(pageAddress);
+}
+
+size_t NuAtlas::FurrBall::AddPageListener(std::function<void(size_t pageAddress)> listener) noexcept
+{
+    std::lock_guard<std::mutex> lock(DataMembers->PageTableMutex);
+    const size_t id = DataMembers->NextPageListener++;
+    DataMembers->PageListeners.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void NuAtlas::FurrBall::RemovePageListener(size_t id) noexcept
+{
+    std::lock_guard<std::mutex> lock(DataMembers->PageTableMutex);
+    auto& listeners = DataMembers->PageListeners;
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+        [id](const auto& listener) { return listener.first == id; }), listeners.end());
+}
+
+void* NuAtlas::FurrBall::Access(void* vAddress, bool write) noexcept
+{
+    const size_t address = reinterpret_cast<size_t>(vAddress);
+    const size_t pageAddress = floorAddress(address);
+    const size_t offset = address - pageAddress;
+    std::unique_lock<std::mutex> lock(DataMembers->PageTableMutex);
+    bool coalesced = false;
+    while (true) {
+        auto it = DataMembers->PageTable.find(pageAddress);
+        if (it != DataMembers->PageTable.end()) {
+            DataMembers->Cache.touch(pageAddress);
+            if (!coalesced) {
+                DataMembers->Stats.PageHits.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (write) {
+                it->second.Dirty = true;
+                DataMembers->InvalidatePage(pageAddress);
+            }
+            it->second.Hits++;
+            return static_cast<char*>(it->second.Frame) + offset;
+        }
+        if (pageAddress > DataMembers->Extent) {
+            //Far from every known page.
+            return nullptr;
+        }
+        auto pending = DataMembers->PendingLoads.find(pageAddress);
+        if (pending == DataMembers->PendingLoads.end()) {
+            break;
+        }
+        //Another thread is reading the page, share its read. If it was not admitted, load it ourselves.
+        if (!coalesced) {
+            DataMembers->Stats.PageMisses.fetch_add(1, std::memory_order_relaxed);
+            DataMembers->Stats.CoalescedMisses.fetch_add(1, std::memory_order_relaxed);
+            coalesced = true;
+        }
+        std::shared_ptr<ImplDetail::PendingLoad> load = pending->second;
+        load->Done.wait(lock, [&load] { return load->Finished; });
+    }
+    if (!coalesced) {
+        DataMembers->Stats.PageMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+    char* staging = MissStaging(PageSize);
+    if (!staging) {
+        FURR_LOG_ERROR("Could not allocate the page buffer of a miss.");
+        return nullptr;
+    }
+    DataMembers->PendingLoads.emplace(pageAddress, std::make_shared<ImplDetail::PendingLoad>());
+    //The read and decompression run outside the lock, hits and misses on other pages go on meanwhile.
+    lock.unlock();
+    uint8_t filter = DataMembers->DefaultFilter;
+    rocksdb::Status status = DataMembers->ReadPage(pageAddress, staging, filter);
+    lock.lock();
+    if (!status.ok() && !status.IsNotFound()) {
+        FURR_LOG_ERROR("Failed to load page: ", status.ToString());
+        DataMembers->FinishLoad(pageAddress);
+        return nullptr;
+    }
+    void* frame = DataMembers->TakeFrame(lock);
+    //Checked after TakeFrame, which may wait with the lock released.
+    if (status.ok() && !DataMembers->Liveness.IsDead(pageAddress / PageSize)) {
+        std::memcpy(frame, staging, PageSize);
+    }
+    else {
+        //Never stored, expired or released while it was read.
+        std::memset(frame, 0, PageSize);
+        status = rocksdb::Status::NotFound();
+    }
+    DataMembers->AdmitPage(pageAddress, frame, filter, status.ok(), write);
+    DataMembers->FinishLoad(pageAddress);
+    FURR_EVENT_DEBUG("Loaded page {}, stored {}, filter {}", pageAddress, status.ok(), filter);
+    DataMembers->WriteBackInlineVictims(lock);
+    DataMembers->ScheduleReclamation(lock);
+    if (DataMembers->External && DataMembers->RecompressInterval.count()) {
+        //Without a thread of its own, recompression is driven by misses.
+        lock.unlock();
+        DataMembers->ScheduleRecompression();
+    }
+    return static_cast<char*>(frame) + offset;
+}
+
+size_t NuAtlas::FurrBall::Preload(void* vAddress, size_t size) noexcept
+{
+    const size_t address = reinterpret_cast<size_t>(vAddress);
+    std::vector<size_t> pages;
+    {
+        std::lock_guard<std::mutex> lock(DataMembers->PageTableMutex);
+        for (size_t pageAddress = floorAddress(address); pageAddress < address + size && pageAddress < DataMembers->Extent;
+            pageAddress += PageSize) {
+            if (!DataMembers->PageTable.count(pageAddress) && !DataMembers->PendingLoads.count(pageAddress)
+                && !DataMembers->Liveness.IsDead(pageAddress / PageSize)) {
+                pages.push_back(pageAddress);
+            }
+        }
+        //More pages than the cache holds would only evict each other.
+        if (pages.size() > DataMembers->Capacity) {
+            pages.resize(DataMembers->Capacity);
+        }
+        //Misses on these pages wait for the preload instead of reading them a second time.
+        for (size_t pageAddress : pages) {
+            DataMembers->PendingLoads.emplace(pageAddress, std::make_shared<ImplDetail::PendingLoad>());
+        }
+    }
+    if (pages.empty()) {
+        return 0;
+    }
+    //Pages are read and decompressed outside the lock, in parallel in burst mode, then admitted together.
+    char* staging = static_cast<char*>(MemoryManager::AllocateMemory(pages.size() * PageSize));
+    std::vector<uint8_t> filters(pages.size(), DataMembers->DefaultFilter);
+    std::vector<uint8_t> loaded(pages.size(), 0);
+    if (staging) {
+        ParallelFor(DataMembers->Executor, pages.size(), [&](size_t i) {
+            loaded[i] = DataMembers->ReadPage(pages[i], staging + i * PageSize, filters[i]).ok();
+        });
+    }
+    size_t admitted = 0;
+    std::unique_lock<std::mutex> lock(DataMembers->PageTableMutex);
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (loaded[i] && !DataMembers->Liveness.IsDead(pages[i] / PageSize)) {
+            void* frame = DataMembers->TakeFrame(lock);
+            //TakeFrame may wait with the lock released, a release meanwhile drops the page.
+            if (DataMembers->Liveness.IsDead(pages[i] / PageSize)) {
+                DataMembers->FreeFrames.push_back(frame);
+                DataMembers->FramesFreed.notify_one();
+            }
+            else {
+                std::memcpy(frame, staging + i * PageSize, PageSize);
+                DataMembers->AdmitPage(pages[i], frame, filters[i], true, false);
+                admitted++;
+            }
+        }
+        DataMembers->FinishLoad(pages[i]);
+        //Before the next TakeFrame, which may need the frames of these victims.
+        DataMembers->WriteBackInlineVictims(lock);
+    }
+    DataMembers->ScheduleReclamation(lock);
+    if (staging) {
+        MemoryManager::FreeMemory(staging);
+    }
+    return admitted;
+}
+
+void NuAtlas::FurrBall::Release(void* vAddress) noexcept
 {
+    const size_t pageAddress = floorAddress(reinterpret_cast<size_t>(vAddress));
+    std::lock_guard<std::mutex> lock(DataMembers->PageTableMutex);
+    if (pageAddress >= DataMembers->Extent) {
+        return;
+    }
+    auto it = DataMembers->PageTable.find(pageAddress);
+    if (it != DataMembers->PageTable.end()) {
+        //Stays resident as a fresh zero page until evicted, without write-back.
+        std::memset(it->second.Frame, 0, PageSize);
+        it->second.Dirty = false;
+        DataMembers->InvalidatePage(pageAddress);
+    }
+    if (!DataMembers->Liveness.MarkDead(pageAddress / PageSize)) {
+        //Out of bitmap space, fall back to a tombstone.
+        char key[PageKeySize];
+        EncodePageKey(pageAddress, key);
+        DataMembers->db->Delete(DataMembers->writeOptions, rocksdb::Slice(key, PageKeySize));
+    }
+}
 
+bool NuAtlas::FurrBall::SetPageFilter(void* vAddress, FurrPageFilter filter, size_t elementSize) noexcept
+{
+    const uint8_t packed = PackPageFilter(filter, elementSize);
+    if (!packed && filter != FurrPageFilter::None) {
+        return false;
+    }
+    const size_t pageAddress = floorAddress(reinterpret_cast<size_t>(vAddress));
+    std::lock_guard<std::mutex> lock(DataMembers->PageTableMutex);
+    auto it = DataMembers->PageTable.find(pageAddress);
+    if (it == DataMembers->PageTable.end()) {
+        return false;
+    }
+    //Dirty so the hint reaches the DB even if the page is not written again.
+    it->second.Filter = packed;
+    it->second.Dirty = true;
+    return true;
+}
+
+FurrStats NuAtlas::FurrBall::GetStats() const noexcept
+{
+    FurrStats stats;
+    DataMembers->Stats.Fill(stats);
+    if (DataMembers->statistics) {
+        FillDBStats(*DataMembers->statistics, stats);
+    }
+    return stats;
+}
+
+void NuAtlas::FurrBall::EnterCriticalPhase(bool pauseBackgroundWork) noexcept
+{
+    std::lock_guard<std::mutex> lock(DataMembers->CriticalMutex);
+    if (DataMembers->CriticalDepth++ == 0 && DataMembers->rateLimiter) {
+        DataMembers->rateLimiter->SetBytesPerSecond(static_cast<int64_t>(DataMembers->CriticalBytesPerSecond));
+    }
+    if (pauseBackgroundWork && !DataMembers->PausedAtDepth) {
+        DataMembers->PausedAtDepth = DataMembers->CriticalDepth;
+        rocksdb::Status status = DataMembers->db->PauseBackgroundWork();
+        if (!status.ok()) {
+            FURR_LOG_WARNING("Failed to pause background work: ", status.ToString());
+        }
+    }
+}
+
+void NuAtlas::FurrBall::LeaveCriticalPhase() noexcept
+{
+    std::lock_guard<std::mutex> lock(DataMembers->CriticalMutex);
+    if (!DataMembers->CriticalDepth) {
+        return;
+    }
+    if (DataMembers->PausedAtDepth == DataMembers->CriticalDepth) {
+        DataMembers->PausedAtDepth = 0;
+        DataMembers->db->ContinueBackgroundWork();
+    }
+    if (--DataMembers->CriticalDepth == 0 && DataMembers->rateLimiter) {
+        DataMembers->rateLimiter->SetBytesPerSecond(static_cast<int64_t>(DataMembers->BackgroundBytesPerSecond));
+    }
+}
+
+size_t NuAtlas::FurrBall::StoreLargeData(const void* buffer, size_t size) noexcept
+{
+    std::string value;
+    EncodeLargeData(buffer, size, DataMembers->LargeDataBlockSize, DataMembers->Codec, value, DataMembers->DecodeExecutor);
+    const uint64_t handle = DataMembers->NextLargeDataHandle.fetch_add(1, std::memory_order_relaxed);
+    char key[LargeDataKeySize];
+    EncodeLargeDataKey(handle, key);
+    rocksdb::Status status = DataMembers->db->Put(DataMembers->writeOptions, rocksdb::Slice(key, LargeDataKeySize), value);
+    if (!status.ok()) {
+        FURR_LOG_ERROR("Failed to store large data: ", status.ToString());
+        return 0;
+    }
+    return static_cast<size_t>(handle);
+}
+
+size_t NuAtlas::FurrBall::LoadLargeData(size_t handle, void* buffer, size_t size) noexcept
+{
+    rocksdb::PinnableSlice value;
+    size_t dataSize = 0;
+    if (!DataMembers->GetLargeData(handle, value, dataSize)) {
+        return 0;
+    }
+    if (dataSize <= size && !DecodeLargeData(value.data(), value.size(), 0, buffer, dataSize, DataMembers->DecodeExecutor)) {
+        FURR_LOG_ERROR("Large data failed to decode.");
+        return 0;
+    }
+    return dataSize;
+}
+
+size_t NuAtlas::FurrBall::LoadLargeData(size_t handle, size_t offset, void* buffer, size_t size) noexcept
+{
+    rocksdb::PinnableSlice value;
+    size_t dataSize = 0;
+    if (!DataMembers->GetLargeData(handle, value, dataSize) || offset >= dataSize) {
+        return 0;
+    }
+    const size_t length = (std::min)(size, dataSize - offset);
+    if (!DecodeLargeData(value.data(), value.size(), offset, buffer, length, DataMembers->DecodeExecutor)) {
+        FURR_LOG_ERROR("Large data failed to decode.");
+        return 0;
+    }
+    return length;
+}
+
+void NuAtlas::FurrBall::ReleaseLargeData(size_t handle) noexcept
+{
+    char key[LargeDataKeySize];
+    EncodeLargeDataKey(handle, key);
+    DataMembers->db->Delete(DataMembers->writeOptions, rocksdb::Slice(key, LargeDataKeySize));
 }
 
 NuAtlas::FurrBall::~FurrBall() noexcept
 {
-    delete DataMembers->db;
+    DataMembers->StopRecompression();
+    DataMembers->StopReclamation();
+    if (DataMembers->db && !DataMembers->isVolatile) {
+        //Persist what is still resident, volatile data dies with the ball.
+        std::vector<std::pair<size_t, const ImplDetail::ResidentPage*>> dirty;
+        for (const auto& [pageAddress, page] : DataMembers->PageTable) {
+            if (page.Dirty) {
+                dirty.emplace_back(pageAddress, &page);
+            }
+        }
+        //Encoded in parallel in burst mode, written in one batch.
+        std::vector<std::string> records(dirty.size());
+        ParallelFor(DataMembers->Executor, dirty.size(), [&](size_t i) {
+            const ImplDetail::ResidentPage& page = *dirty[i].second;
+            DataMembers->EncodeRecord(page.Frame, page.Hits >= ImplDetail::HotPageHits, page.Filter, records[i]);
+        });
+        rocksdb::WriteBatch writeBack;
+        for (size_t i = 0; i < dirty.size(); i++) {
+            char key[PageKeySize];
+            EncodePageKey(dirty[i].first, key);
+            writeBack.Put(rocksdb::Slice(key, PageKeySize), records[i]);
+            DataMembers->Liveness.MarkLive(dirty[i].first / PageSize);
+        }
+        if (writeBack.Count()) {
+            rocksdb::Status status = DataMembers->db->Write(DataMembers->writeOptions, &writeBack);
+            if (!status.ok()) {
+                FURR_LOG_ERROR("Failed to write back pages: ", status.ToString());
+            }
+        }
+        //Released pages that compaction did not reach yet must not come back on reopen.
+        rocksdb::WriteBatch tombstones;
+        DataMembers->Liveness.ForEachDead([&](size_t pageIndex) {
+            char key[PageKeySize];
+            EncodePageKey(pageIndex * PageSize, key);
+            tombstones.Delete(rocksdb::Slice(key, PageKeySize));
+        });
+        if (tombstones.Count()) {
+            DataMembers->db->Write(DataMembers->writeOptions, &tombstones);
+        }
+    }
+    delete DataMembers;
 }
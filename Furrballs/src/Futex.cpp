@@ -0,0 +1,53 @@
+/*****************************************************************//**
+ * \file   Futex.cpp
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+
+#include "Futex.h"
+#include <climits>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+//std::atomic<uint32_t> is waited on in place.
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The futex word must be a plain 32 bit word.");
+
+void NuAtlas::FutexWait(std::atomic<uint32_t>& word, uint32_t expected) noexcept
+{
+#ifdef _WIN32
+    WaitOnAddress(&word, &expected, sizeof(expected), INFINITE);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+#endif
+}
+
+void NuAtlas::FutexWake(std::atomic<uint32_t>& word, uint32_t count) noexcept
+{
+#ifdef _WIN32
+    if (count == 1) {
+        WakeByAddressSingle(&word);
+    }
+    else {
+        WakeByAddressAll(&word);
+    }
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count ? (count > INT_MAX ? INT_MAX : count) : INT_MAX,
+        nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)count;
+#endif
+}
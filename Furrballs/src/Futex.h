@@ -0,0 +1,24 @@
+/*****************************************************************//**
+ * \file   Futex.h
+ * \brief  Waiting on a 32 bit word, the kernel only gets involved when a thread really sleeps or must be woken.
+ *
+ * futex on Linux, WaitOnAddress on Windows, short sleeps elsewhere.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace NuAtlas {
+    /**
+     * @brief Sleeps while word holds expected. May return spuriously, callers recheck their condition.
+     */
+    void FutexWait(std::atomic<uint32_t>& word, uint32_t expected) noexcept;
+
+    /**
+     * @brief Wakes up to count threads waiting on word, all of them if count is 0.
+     */
+    void FutexWake(std::atomic<uint32_t>& word, uint32_t count) noexcept;
+}
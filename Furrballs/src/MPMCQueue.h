@@ -0,0 +1,140 @@
+/*****************************************************************//**
+ * \file   MPMCQueue.h
+ * \brief  Bounded lock-free multi-producer multi-consumer ring, after Dmitry Vyukov's queue.
+ *
+ * Every cell carries a sequence number telling producers and consumers of which lap it is free or full,
+ * so a push or pop is one CAS on the shared position plus a release store on the cell.
+ * Cells and both positions sit on their own cache lines.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace NuAtlas {
+    template<class T>
+    class MPMCQueue final {
+        static_assert(std::is_nothrow_move_assignable<T>::value, "Cells are filled and emptied by move.");
+    private:
+        struct alignas(64) Cell {
+            std::atomic<size_t> Sequence;
+            T Value;
+        };
+
+        std::unique_ptr<Cell[]> Cells;
+        const size_t Mask;
+        alignas(64) std::atomic<size_t> Tail{ 0 };
+        alignas(64) std::atomic<size_t> Head{ 0 };
+
+        static size_t RoundUp(size_t capacity) noexcept {
+            size_t rounded = 2;
+            while (rounded < capacity) {
+                rounded <<= 1;
+            }
+            return rounded;
+        }
+
+        /**
+         * @brief Claims up to count consecutive cells at position, whose sequence is position + i + lag when ready.
+         * @returns The number of cells claimed, 0 if none is ready.
+         */
+        size_t Claim(std::atomic<size_t>& position, size_t count, size_t lag, size_t& first) noexcept {
+            size_t pos = position.load(std::memory_order_relaxed);
+            while (true) {
+                size_t ready = 0;
+                while (ready < count) {
+                    const size_t sequence = Cells[(pos + ready) & Mask].Sequence.load(std::memory_order_acquire);
+                    if (sequence != pos + ready + lag) {
+                        break;
+                    }
+                    ready++;
+                }
+                if (!ready) {
+                    const size_t sequence = Cells[pos & Mask].Sequence.load(std::memory_order_acquire);
+                    //Behind: the ring is full or empty. Ahead: another thread claimed the cell, reload.
+                    if (static_cast<std::ptrdiff_t>(sequence - (pos + lag)) < 0) {
+                        return 0;
+                    }
+                    pos = position.load(std::memory_order_relaxed);
+                    continue;
+                }
+                //Every checked cell stays ready until its position is claimed, so the CAS claims them all.
+                if (position.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                    first = pos;
+                    return ready;
+                }
+            }
+        }
+
+    public:
+        /**
+         * @param capacity Rounded up to a power of two.
+         */
+        explicit MPMCQueue(size_t capacity) : Cells(new Cell[RoundUp(capacity)]), Mask(RoundUp(capacity) - 1) {
+            for (size_t i = 0; i <= Mask; i++) {
+                Cells[i].Sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+        /**
+         * @returns false if the ring is full.
+         */
+        bool TryPush(T value) noexcept {
+            return PushBatch(&value, 1) == 1;
+        }
+
+        /**
+         * @returns false if the ring is empty.
+         */
+        bool TryPop(T& value) noexcept {
+            return PopBatch(&value, 1) == 1;
+        }
+
+        /**
+         * @brief Pushes as many of the count values as fit in one claim, moving from them.
+         * @returns The number pushed, the first ones of values.
+         */
+        size_t PushBatch(T* values, size_t count) noexcept {
+            size_t first = 0;
+            const size_t claimed = Claim(Tail, count, 0, first);
+            for (size_t i = 0; i < claimed; i++) {
+                Cell& cell = Cells[(first + i) & Mask];
+                cell.Value = std::move(values[i]);
+                cell.Sequence.store(first + i + 1, std::memory_order_release);
+            }
+            return claimed;
+        }
+
+        /**
+         * @brief Pops up to count values in FIFO order.
+         * @returns The number popped.
+         */
+        size_t PopBatch(T* values, size_t count) noexcept {
+            size_t first = 0;
+            const size_t claimed = Claim(Head, count, 1, first);
+            for (size_t i = 0; i < claimed; i++) {
+                Cell& cell = Cells[(first + i) & Mask];
+                values[i] = std::move(cell.Value);
+                //Free for the next lap.
+                cell.Sequence.store(first + i + Mask + 1, std::memory_order_release);
+            }
+            return claimed;
+        }
+
+        /**
+         * @brief A snapshot, other threads may push or pop right after.
+         */
+        bool Empty() const noexcept {
+            return Head.load(std::memory_order_acquire) >= Tail.load(std::memory_order_acquire);
+        }
+
+        size_t Capacity() const noexcept { return Mask + 1; }
+    };
+}
@@ -0,0 +1,470 @@
+/*****************************************************************//**
+ * \file   PageCodec.cpp
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+
+#include "PageCodec.h"
+#include "PageFilter.h"
+#include "WorkStealingPool.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <lz4.h>
+#include <lz4hc.h>
+
+using namespace NuAtlas;
+
+namespace {
+    /**
+     * @brief Per-thread compression output, grown through MemoryManager and kept for the thread's lifetime.
+     */
+    struct CodecScratch {
+        char* Buffer = nullptr;
+        size_t Capacity = 0;
+
+        char* Reserve(size_t size) noexcept {
+            if (size > Capacity) {
+                void* grown = MemoryManager::AllocateMemory(size);
+                if (!grown) {
+                    return nullptr;
+                }
+                if (Buffer) {
+                    MemoryManager::FreeMemory(Buffer);
+                }
+                Buffer = static_cast<char*>(grown);
+                Capacity = size;
+            }
+            return Buffer;
+        }
+
+        ~CodecScratch() {
+            if (Buffer) {
+                MemoryManager::FreeMemory(Buffer);
+            }
+        }
+    };
+    thread_local CodecScratch Scratch;
+    /**
+     * @brief Per-thread filtered copy of the page being encoded or decoded.
+     */
+    thread_local CodecScratch FilterScratch;
+
+    /**
+     * @brief Per-thread LZ4 stream, reset from a dictionary's stream before each page.
+     */
+    struct StreamScratch {
+        LZ4_stream_t* Stream = nullptr;
+
+        LZ4_stream_t* Get() noexcept {
+            if (!Stream) {
+                Stream = static_cast<LZ4_stream_t*>(MemoryManager::AllocateMemory(sizeof(LZ4_stream_t)));
+            }
+            return Stream;
+        }
+
+        ~StreamScratch() {
+            if (Stream) {
+                MemoryManager::FreeMemory(Stream);
+            }
+        }
+    };
+    thread_local StreamScratch WorkingStream;
+
+    /**
+     * @brief Per-thread LZ4HC state, large enough (~256KB) that it is only allocated by threads compressing cold pages.
+     */
+    struct HCScratch {
+        LZ4_streamHC_t* Stream = nullptr;
+
+        LZ4_streamHC_t* Get() noexcept {
+            if (!Stream) {
+                void* memory = MemoryManager::AllocateMemory(sizeof(LZ4_streamHC_t));
+                if (memory) {
+                    Stream = LZ4_initStreamHC(memory, sizeof(LZ4_streamHC_t));
+                }
+            }
+            return Stream;
+        }
+
+        ~HCScratch() {
+            if (Stream) {
+                MemoryManager::FreeMemory(Stream);
+            }
+        }
+    };
+    thread_local HCScratch HCStream;
+
+    /**
+     * @brief Above this many bits per byte a page is treated as incompressible.
+     */
+    constexpr double IncompressibleEntropy = 7.2;
+    constexpr size_t EntropySamples = 1024;
+
+    constexpr uint32_t LargeDataMagic = 0x4C525546; //"FURL"
+    constexpr uint32_t RawBlockFlag = 0x80000000u;
+    constexpr size_t LargeDataFooterSize = sizeof(uint64_t) + 3 * sizeof(uint32_t);
+
+    template<class T>
+    void PutFixed(char* out, T value) noexcept {
+        for (size_t i = 0; i < sizeof(T); i++) {
+            out[i] = static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xFF);
+        }
+    }
+
+    template<class T>
+    T GetFixed(const char* in) noexcept {
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+        }
+        return static_cast<T>(value);
+    }
+
+    /**
+     * @brief Encoded large data, with the seek table and footer checked against the value size.
+     */
+    struct LargeDataLayout {
+        size_t Size = 0;
+        size_t BlockSize = 0;
+        size_t BlockCount = 0;
+        const char* Table = nullptr;
+        size_t PayloadSize = 0;
+
+        bool Parse(const char* value, size_t valueSize) noexcept {
+            if (valueSize < LargeDataFooterSize) {
+                return false;
+            }
+            const char* footer = value + valueSize - LargeDataFooterSize;
+            if (GetFixed<uint32_t>(footer + 16) != LargeDataMagic) {
+                return false;
+            }
+            Size = static_cast<size_t>(GetFixed<uint64_t>(footer));
+            BlockSize = GetFixed<uint32_t>(footer + 8);
+            BlockCount = GetFixed<uint32_t>(footer + 12);
+            if (BlockSize < MinLargeDataBlockSize || BlockSize > MaxLargeDataBlockSize
+                || BlockCount != (Size + BlockSize - 1) / BlockSize
+                || BlockCount > (valueSize - LargeDataFooterSize) / sizeof(uint32_t)) {
+                return false;
+            }
+            PayloadSize = valueSize - LargeDataFooterSize - BlockCount * sizeof(uint32_t);
+            Table = value + PayloadSize;
+            return true;
+        }
+
+        size_t RawSize(size_t block) const noexcept {
+            return (std::min)(BlockSize, Size - block * BlockSize);
+        }
+    };
+}
+
+double NuAtlas::EstimateEntropy(const void* page, size_t pageSize) noexcept
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(page);
+    const size_t stride = pageSize > EntropySamples ? pageSize / EntropySamples : 1;
+    uint32_t histogram[256] = {};
+    size_t samples = 0;
+    for (size_t i = 0; i < pageSize; i += stride, samples++) {
+        histogram[bytes[i]]++;
+    }
+    double entropy = 0;
+    for (uint32_t count : histogram) {
+        if (count) {
+            const double p = static_cast<double>(count) / samples;
+            entropy -= p * std::log2(p);
+        }
+    }
+    return entropy;
+}
+
+PageDictionary* NuAtlas::PageDictionary::Create(const char* data, size_t size) noexcept
+{
+    if (!data || !size) {
+        return nullptr;
+    }
+    if (size > MaxSize) {
+        data += size - MaxSize;
+        size = MaxSize;
+    }
+    //Allocated up front so the constructor has nothing that can fail.
+    char* copy = static_cast<char*>(MemoryManager::AllocateMemory(size));
+    void* stream = MemoryManager::AllocateMemory(sizeof(LZ4_stream_t));
+    if (!copy || !stream) {
+        if (copy) {
+            MemoryManager::FreeMemory(copy);
+        }
+        if (stream) {
+            MemoryManager::FreeMemory(stream);
+        }
+        return nullptr;
+    }
+    std::memcpy(copy, data, size);
+    LZ4_stream_t* lz4Stream = LZ4_initStream(stream, sizeof(LZ4_stream_t));
+    LZ4_loadDict(lz4Stream, copy, static_cast<int>(size));
+    PageDictionary* dictionary = new PageDictionary();
+    dictionary->Data = copy;
+    dictionary->Size = size;
+    dictionary->Stream = stream;
+    return dictionary;
+}
+
+NuAtlas::PageDictionary::~PageDictionary()
+{
+    MemoryManager::FreeMemory(Stream);
+    MemoryManager::FreeMemory(Data);
+}
+
+EncodedPage NuAtlas::EncodePage(const void* page, size_t pageSize, const CodecSettings& settings, bool hot,
+    const PageDictionary* dictionary, uint8_t filter) noexcept
+{
+    EncodedPage raw;
+    raw.Data = static_cast<const char*>(page);
+    raw.Size = pageSize;
+    if (settings.Compression == FurrCompression::None) {
+        return raw;
+    }
+    const char* src = static_cast<const char*>(page);
+    if (filter) {
+        //Typed data often looks random byte by byte, the filter is what exposes its redundancy.
+        char* filtered = FilterScratch.Reserve(pageSize);
+        if (!filtered) {
+            return raw;
+        }
+        ApplyPageFilter(filter, page, filtered, pageSize);
+        src = filtered;
+        dictionary = nullptr;
+    }
+    //A strided sample is far cheaper than a trial compression that would be thrown away.
+    else if (EstimateEntropy(page, pageSize) >= IncompressibleEntropy) {
+        return raw;
+    }
+    const int bound = LZ4_compressBound(static_cast<int>(pageSize));
+    char* out = Scratch.Reserve(static_cast<size_t>(bound));
+    if (!out) {
+        return raw;
+    }
+    const int srcSize = static_cast<int>(pageSize);
+    const bool useHC = settings.Compression == FurrCompression::LZ4HC || (!hot && settings.HCLevel > 0);
+    EncodedPage encoded;
+    encoded.Data = out;
+    int compressed = 0;
+    LZ4_streamHC_t* hcStream = useHC ? HCStream.Get() : nullptr;
+    if (hcStream) {
+        const int level = settings.HCLevel > 0 ? settings.HCLevel : LZ4HC_CLEVEL_DEFAULT;
+        LZ4_resetStreamHC_fast(hcStream, level);
+        if (dictionary) {
+            LZ4_loadDictHC(hcStream, dictionary->GetData(), static_cast<int>(dictionary->GetSize()));
+            encoded.Codec = PageCodec::LZ4HCDict;
+        }
+        else {
+            encoded.Codec = PageCodec::LZ4HC;
+        }
+        compressed = LZ4_compress_HC_continue(hcStream, src, out, srcSize, bound);
+    }
+    else {
+        LZ4_stream_t* stream = dictionary ? WorkingStream.Get() : nullptr;
+        if (stream) {
+            //Copying the loaded state is far cheaper than hashing the dictionary again for every page.
+            std::memcpy(stream, dictionary->GetStream(), sizeof(LZ4_stream_t));
+            compressed = LZ4_compress_fast_continue(stream, src, out, srcSize, bound, settings.Acceleration);
+            encoded.Codec = PageCodec::LZ4Dict;
+        }
+        else {
+            compressed = LZ4_compress_fast(src, out, srcSize, bound, settings.Acceleration);
+            encoded.Codec = PageCodec::LZ4;
+        }
+    }
+    //Hot pages favor decode speed: a small saving is not worth decoding on every load.
+    const size_t minSaving = hot ? pageSize / 4 : pageSize / 8;
+    if (compressed <= 0 || static_cast<size_t>(compressed) + minSaving > pageSize) {
+        return raw;
+    }
+    encoded.Size = static_cast<size_t>(compressed);
+    return encoded;
+}
+
+bool NuAtlas::DecodePage(PageCodec codec, const char* data, size_t size, void* frame, size_t pageSize,
+    const PageDictionary* dictionary, uint8_t filter) noexcept
+{
+    if (filter && codec != PageCodec::Raw) {
+        char* filtered = FilterScratch.Reserve(pageSize);
+        if (!filtered || !DecodePage(codec, data, size, filtered, pageSize, dictionary)) {
+            return false;
+        }
+        RevertPageFilter(filter, filtered, frame, pageSize);
+        return true;
+    }
+    switch (codec) {
+    case PageCodec::Raw:
+        if (size > pageSize) {
+            return false;
+        }
+        std::memcpy(frame, data, size);
+        if (size < pageSize) {
+            std::memset(static_cast<char*>(frame) + size, 0, pageSize - size);
+        }
+        return true;
+    case PageCodec::LZ4:
+    case PageCodec::LZ4HC:
+        return LZ4_decompress_safe(data, static_cast<char*>(frame), static_cast<int>(size), static_cast<int>(pageSize))
+            == static_cast<int>(pageSize);
+    case PageCodec::LZ4Dict:
+    case PageCodec::LZ4HCDict:
+        if (!dictionary) {
+            return false;
+        }
+        return LZ4_decompress_safe_usingDict(data, static_cast<char*>(frame), static_cast<int>(size), static_cast<int>(pageSize),
+            dictionary->GetData(), static_cast<int>(dictionary->GetSize())) == static_cast<int>(pageSize);
+    default:
+        return false;
+    }
+}
+
+void NuAtlas::EncodeLargeData(const void* data, size_t size, size_t blockSize, const CodecSettings& settings, std::string& out,
+    IExecutor* executor)
+{
+    const char* src = static_cast<const char*>(data);
+    const size_t blockCount = (size + blockSize - 1) / blockSize;
+    const int bound = LZ4_compressBound(static_cast<int>(blockSize));
+    //Sized for the worst case up front, blocks compress straight into the value.
+    out.resize(blockCount * (static_cast<size_t>(bound) + sizeof(uint32_t)) + LargeDataFooterSize);
+    char* base = &out[0];
+    std::vector<uint32_t> table(blockCount);
+    auto encodeBlock = [&](size_t block, char* dst) -> uint32_t {
+        const char* blockData = src + block * blockSize;
+        const int rawSize = static_cast<int>((std::min)(blockSize, size - block * blockSize));
+        int compressed = 0;
+        if (settings.Compression != FurrCompression::None && EstimateEntropy(blockData, rawSize) < IncompressibleEntropy) {
+            LZ4_streamHC_t* hcStream = settings.Compression == FurrCompression::LZ4HC ? HCStream.Get() : nullptr;
+            if (hcStream) {
+                //A reset stream has no history, every block stays independent.
+                LZ4_resetStreamHC_fast(hcStream, settings.HCLevel > 0 ? settings.HCLevel : LZ4HC_CLEVEL_DEFAULT);
+                compressed = LZ4_compress_HC_continue(hcStream, blockData, dst, rawSize, bound);
+            }
+            else {
+                compressed = LZ4_compress_fast(blockData, dst, rawSize, bound, settings.Acceleration);
+            }
+        }
+        if (compressed > 0 && compressed < rawSize) {
+            return static_cast<uint32_t>(compressed);
+        }
+        std::memcpy(dst, blockData, rawSize);
+        return static_cast<uint32_t>(rawSize) | RawBlockFlag;
+    };
+    size_t pos = 0;
+    if (executor && blockCount > 1) {
+        //Every block gets a worst-case slot so workers never share output, the slots are packed afterwards.
+        ParallelFor(executor, blockCount, [&](size_t block) {
+            table[block] = encodeBlock(block, base + block * static_cast<size_t>(bound));
+        });
+        for (size_t block = 0; block < blockCount; block++) {
+            const size_t stored = table[block] & ~RawBlockFlag;
+            std::memmove(base + pos, base + block * static_cast<size_t>(bound), stored);
+            pos += stored;
+        }
+    }
+    else {
+        for (size_t block = 0; block < blockCount; block++) {
+            table[block] = encodeBlock(block, base + pos);
+            pos += table[block] & ~RawBlockFlag;
+        }
+    }
+    for (uint32_t entry : table) {
+        PutFixed<uint32_t>(base + pos, entry);
+        pos += sizeof(uint32_t);
+    }
+    PutFixed<uint64_t>(base + pos, size);
+    PutFixed<uint32_t>(base + pos + 8, static_cast<uint32_t>(blockSize));
+    PutFixed<uint32_t>(base + pos + 12, static_cast<uint32_t>(blockCount));
+    PutFixed<uint32_t>(base + pos + 16, LargeDataMagic);
+    out.resize(pos + LargeDataFooterSize);
+}
+
+bool NuAtlas::LargeDataSize(const char* value, size_t valueSize, size_t& size) noexcept
+{
+    LargeDataLayout layout;
+    if (!layout.Parse(value, valueSize)) {
+        return false;
+    }
+    size = layout.Size;
+    return true;
+}
+
+bool NuAtlas::DecodeLargeData(const char* value, size_t valueSize, size_t offset, void* buffer, size_t length,
+    IExecutor* executor) noexcept
+{
+    LargeDataLayout layout;
+    if (!layout.Parse(value, valueSize) || offset > layout.Size || length > layout.Size - offset) {
+        return false;
+    }
+    if (!length) {
+        return true;
+    }
+    const size_t first = offset / layout.BlockSize;
+    const size_t last = (offset + length - 1) / layout.BlockSize;
+    size_t pos = 0;
+    for (size_t block = 0; block < first; block++) {
+        pos += GetFixed<uint32_t>(layout.Table + block * sizeof(uint32_t)) & ~RawBlockFlag;
+    }
+    char* out = static_cast<char*>(buffer);
+    auto decodeBlock = [&](size_t block, size_t blockPos) -> bool {
+        const uint32_t entry = GetFixed<uint32_t>(layout.Table + block * sizeof(uint32_t));
+        const size_t stored = entry & ~RawBlockFlag;
+        const size_t rawSize = layout.RawSize(block);
+        const size_t blockStart = block * layout.BlockSize;
+        const size_t from = (std::max)(offset, blockStart) - blockStart;
+        const size_t to = (std::min)(offset + length, blockStart + rawSize) - blockStart;
+        char* dst = out + (blockStart + from - offset);
+        if (blockPos > layout.PayloadSize || stored > layout.PayloadSize - blockPos) {
+            return false;
+        }
+        const char* src = value + blockPos;
+        if (entry & RawBlockFlag) {
+            if (stored != rawSize) {
+                return false;
+            }
+            std::memcpy(dst, src + from, to - from);
+            return true;
+        }
+        if (from == 0 && to == rawSize) {
+            return LZ4_decompress_safe(src, dst, static_cast<int>(stored), static_cast<int>(rawSize)) == static_cast<int>(rawSize);
+        }
+        //Edge blocks only decode up to the end of the range.
+        char* scratch = Scratch.Reserve(rawSize);
+        if (!scratch) {
+            return false;
+        }
+        const int decoded = LZ4_decompress_safe_partial(src, scratch, static_cast<int>(stored),
+            static_cast<int>(to), static_cast<int>(rawSize));
+        if (decoded < static_cast<int>(to)) {
+            return false;
+        }
+        std::memcpy(dst, scratch + from, to - from);
+        return true;
+    };
+    if (!executor || first == last) {
+        for (size_t block = first; block <= last; block++) {
+            if (!decodeBlock(block, pos)) {
+                return false;
+            }
+            pos += GetFixed<uint32_t>(layout.Table + block * sizeof(uint32_t)) & ~RawBlockFlag;
+        }
+        return true;
+    }
+    //Block positions come from the seek table up front, then every block decodes into its own part of the buffer.
+    std::vector<size_t> positions(last - first + 1);
+    for (size_t block = first; block <= last; block++) {
+        positions[block - first] = pos;
+        pos += GetFixed<uint32_t>(layout.Table + block * sizeof(uint32_t)) & ~RawBlockFlag;
+    }
+    std::atomic<bool> valid{ true };
+    ParallelFor(executor, positions.size(), [&](size_t i) {
+        if (!decodeBlock(first + i, positions[i])) {
+            valid.store(false, std::memory_order_relaxed);
+        }
+    });
+    return valid.load(std::memory_order_relaxed);
+}
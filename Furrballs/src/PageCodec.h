@@ -0,0 +1,167 @@
+/*****************************************************************//**
+ * \file   PageCodec.h
+ * \brief  Per-page and large data compression done by FurrBall itself.
+ *
+ * Pages are compressed one by one and stored uncompressed by the DB, so a page load
+ * decompresses exactly one page, straight from the pinned DB value into its frame.
+ * Large data is cut into independently compressed blocks for the same reason, a read decompresses
+ * only the blocks covering its range.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Furrballs.h"
+
+namespace NuAtlas {
+    class IExecutor;
+
+    /**
+     * @brief Codec a stored page is encoded with, recorded in its PageRecordHeader.
+     */
+    enum class PageCodec : uint8_t {
+        Raw = 0,
+        LZ4 = 1,
+        /**
+         * @brief LZ4 against the ball's PageDictionary.
+         */
+        LZ4Dict = 2,
+        /**
+         * @brief LZ4HC output, decoded exactly like LZ4.
+         */
+        LZ4HC = 3,
+        LZ4HCDict = 4
+    };
+
+    /**
+     * @brief How a ball compresses its pages.
+     */
+    struct CodecSettings {
+        /**
+         * @brief None, LZ4 (adaptive) or LZ4HC (always high compression).
+         */
+        FurrCompression Compression = FurrCompression::LZ4;
+        /**
+         * @brief Acceleration of LZ4 fast, higher trades ratio for speed.
+         */
+        int Acceleration = 1;
+        /**
+         * @brief LZ4HC level used for cold pages, 0 keeps cold pages on LZ4 fast.
+         */
+        int HCLevel = 0;
+    };
+
+    /**
+     * @brief LZ4 dictionary shared by the pages of a ball.
+     *
+     * LZ4 has too little history within a small page to compress it well, compressing against
+     * content sampled from representative pages gives it that history back.
+     * The dictionary is loaded into a stream once, each compression starts from a copy of that stream.
+     */
+    class PageDictionary final {
+    private:
+        char* Data = nullptr;
+        size_t Size = 0;
+        void* Stream = nullptr;
+
+        PageDictionary() = default;
+    public:
+        /**
+         * @brief LZ4 only looks back 64KB, larger dictionaries are truncated to their last 64KB.
+         */
+        static constexpr size_t MaxSize = 64 * 1024;
+
+        /**
+         * @brief Copies the dictionary content and prepares it for compression.
+         * @returns nullptr on failure.
+         */
+        static PageDictionary* Create(const char* data, size_t size)noexcept;
+
+        PageDictionary(const PageDictionary&) = delete;
+        PageDictionary& operator=(const PageDictionary&) = delete;
+
+        const char* GetData()const noexcept { return Data; }
+        size_t GetSize()const noexcept { return Size; }
+        /**
+         * @brief The LZ4 stream state with the dictionary loaded.
+         */
+        const void* GetStream()const noexcept { return Stream; }
+
+        ~PageDictionary();
+    };
+
+    /**
+     * @brief A page ready to be stored. Data points either to the page itself or to thread-local scratch,
+     * valid until the next EncodePage on the same thread.
+     */
+    struct EncodedPage {
+        const char* Data = nullptr;
+        size_t Size = 0;
+        PageCodec Codec = PageCodec::Raw;
+    };
+
+    /**
+     * @brief Estimates the entropy of a page in bits per byte from a strided sample of its bytes.
+     */
+    double EstimateEntropy(const void* page, size_t pageSize)noexcept;
+
+    /**
+     * @brief Compresses a page with the codec that suits it.
+     * 
+     * Pages that look incompressible (already compressed textures, audio...) skip the codec entirely.
+     * Hot pages use LZ4 fast and are only kept compressed if they shrink by a quarter, a raw load is a plain copy.
+     * Cold pages use LZ4HC, which decodes as fast as LZ4 for a better ratio, and are kept if they shrink by an eighth.
+     * Filtered pages skip the incompressibility check and the dictionary, the filter is what makes them compress.
+     * @param hot Whether the page is read often.
+     * @param dictionary Compresses against it if not null.
+     * @param filter Packed filter (see PackPageFilter) applied before compression, raw pages stay unfiltered.
+     */
+    EncodedPage EncodePage(const void* page, size_t pageSize, const CodecSettings& settings, bool hot,
+        const PageDictionary* dictionary = nullptr, uint8_t filter = 0)noexcept;
+
+    /**
+     * @brief Decodes a stored page into its frame.
+     * @param dictionary Required by pages encoded with PageCodec::LZ4Dict.
+     * @param filter The filter the page was encoded with, reverted after decompression.
+     * @returns false if the data is corrupted or does not decode to exactly pageSize bytes.
+     */
+    bool DecodePage(PageCodec codec, const char* data, size_t size, void* frame, size_t pageSize,
+        const PageDictionary* dictionary = nullptr, uint8_t filter = 0)noexcept;
+
+    /**
+     * @brief Bounds of the block size large data is cut into.
+     */
+    constexpr size_t MinLargeDataBlockSize = 4 * 1024;
+    constexpr size_t MaxLargeDataBlockSize = 4 * 1024 * 1024;
+
+    /**
+     * @brief Encodes large data as independently compressed blocks followed by a seek table.
+     *
+     * Layout, little-endian: the blocks, then one 32 bit stored size per block (high bit set if the block
+     * is stored raw, as in the LZ4 frame format), then the footer: 64 bit data size, 32 bit block size,
+     * 32 bit block count and a 32 bit magic number.
+     * Blocks that look incompressible or do not shrink are stored raw.
+     * @param blockSize Between MinLargeDataBlockSize and MaxLargeDataBlockSize.
+     * @param executor Compresses the blocks in parallel if not null.
+     */
+    void EncodeLargeData(const void* data, size_t size, size_t blockSize, const CodecSettings& settings, std::string& out,
+        IExecutor* executor = nullptr);
+
+    /**
+     * @brief Reads the size of the data encoded by EncodeLargeData.
+     * @returns false if the value is not valid encoded large data.
+     */
+    bool LargeDataSize(const char* value, size_t valueSize, size_t& size)noexcept;
+
+    /**
+     * @brief Decodes length bytes starting at offset, decompressing only the blocks covering them.
+     * The range must lie within the data, see LargeDataSize.
+     * @param executor Decompresses the blocks in parallel if not null.
+     * @returns false if the value is corrupted.
+     */
+    bool DecodeLargeData(const char* value, size_t valueSize, size_t offset, void* buffer, size_t length,
+        IExecutor* executor = nullptr)noexcept;
+}
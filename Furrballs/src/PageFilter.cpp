@@ -0,0 +1,178 @@
+/*****************************************************************//**
+ * \file   PageFilter.cpp
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+
+#include "PageFilter.h"
+#include "PageFilterKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FURR_FILTER_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+using namespace NuAtlas;
+
+static_assert(static_cast<uint8_t>(FurrPageFilter::ByteShuffle) == FilterKernels::KindByteShuffle
+    && static_cast<uint8_t>(FurrPageFilter::BitShuffle) == FilterKernels::KindBitShuffle
+    && static_cast<uint8_t>(FurrPageFilter::Delta) == FilterKernels::KindDelta, "Kernel kinds must mirror FurrPageFilter");
+
+namespace {
+#ifdef FURR_FILTER_X86
+    /**
+     * @brief SSE2 traits for the filter kernels, SSE2 is part of every x86-64 CPU.
+     */
+    struct SSE2 {
+        using Reg = __m128i;
+        static constexpr size_t Width = 16;
+        static constexpr bool HasPrefixSum = true;
+
+        static Reg Load(const uint8_t* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static void Store(uint8_t* p, Reg v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+        static Reg Zero() noexcept { return _mm_setzero_si128(); }
+        static Reg Or(Reg a, Reg b) noexcept { return _mm_or_si128(a, b); }
+
+        static void Deinterleave(Reg a, Reg b, Reg& even, Reg& odd) noexcept {
+            const __m128i low = _mm_set1_epi16(0x00FF);
+            even = _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low));
+            odd = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+        }
+
+        static void Interleave(Reg a, Reg b, Reg& low, Reg& high) noexcept {
+            low = _mm_unpacklo_epi8(a, b);
+            high = _mm_unpackhi_epi8(a, b);
+        }
+
+        static uint32_t MoveMask(Reg v) noexcept { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+        static Reg ShiftBitsLeft(Reg v) noexcept { return _mm_slli_epi16(v, 1); }
+
+        static Reg ExpandBits(uint32_t mask, unsigned bit) noexcept {
+            const __m128i select = _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+            const __m128i spread = _mm_set_epi64x(static_cast<long long>(((mask >> 8) & 0xFF) * 0x0101010101010101ULL),
+                static_cast<long long>((mask & 0xFF) * 0x0101010101010101ULL));
+            const __m128i set = _mm_cmpeq_epi8(_mm_and_si128(spread, select), select);
+            return _mm_and_si128(set, _mm_set1_epi8(static_cast<char>(1 << bit)));
+        }
+
+        template<size_t E>
+        static Reg Add(Reg a, Reg b) noexcept {
+            if constexpr (E == 1) return _mm_add_epi8(a, b);
+            else if constexpr (E == 2) return _mm_add_epi16(a, b);
+            else if constexpr (E == 4) return _mm_add_epi32(a, b);
+            else return _mm_add_epi64(a, b);
+        }
+
+        template<size_t E>
+        static Reg Sub(Reg a, Reg b) noexcept {
+            if constexpr (E == 1) return _mm_sub_epi8(a, b);
+            else if constexpr (E == 2) return _mm_sub_epi16(a, b);
+            else if constexpr (E == 4) return _mm_sub_epi32(a, b);
+            else return _mm_sub_epi64(a, b);
+        }
+
+        /**
+         * @brief Running sum of the elements of a register, in log2(16 / E) steps.
+         */
+        template<size_t E>
+        static Reg PrefixSum(Reg x) noexcept {
+            x = Add<E>(x, _mm_slli_si128(x, E));
+            if constexpr (E * 2 < Width) x = Add<E>(x, _mm_slli_si128(x, E * 2));
+            if constexpr (E * 4 < Width) x = Add<E>(x, _mm_slli_si128(x, E * 4));
+            if constexpr (E * 8 < Width) x = Add<E>(x, _mm_slli_si128(x, E * 8));
+            return x;
+        }
+
+        template<size_t E>
+        static Reg Splat(FilterKernels::Element<E> value) noexcept {
+            if constexpr (E == 1) return _mm_set1_epi8(static_cast<char>(value));
+            else if constexpr (E == 2) return _mm_set1_epi16(static_cast<short>(value));
+            else if constexpr (E == 4) return _mm_set1_epi32(static_cast<int>(value));
+            else return _mm_set1_epi64x(static_cast<long long>(value));
+        }
+
+        template<size_t E>
+        static Reg BroadcastLast(Reg x) noexcept {
+            if constexpr (E == 1) {
+                const __m128i high = _mm_shufflehi_epi16(_mm_unpackhi_epi8(x, x), 0xFF);
+                return _mm_unpackhi_epi64(high, high);
+            }
+            else if constexpr (E == 2) {
+                const __m128i high = _mm_shufflehi_epi16(x, 0xFF);
+                return _mm_unpackhi_epi64(high, high);
+            }
+            else if constexpr (E == 4) return _mm_shuffle_epi32(x, 0xFF);
+            else return _mm_unpackhi_epi64(x, x);
+        }
+    };
+
+    bool DetectAVX2() noexcept {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        //AVX needs both the CPU and the OS saving the YMM registers.
+        const bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+        if (!osSavesYmm) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    bool HasAVX2() noexcept {
+        static const bool supported = DetectAVX2();
+        return supported;
+    }
+    using Best = SSE2;
+#else
+    using Best = void;
+#endif
+}
+
+uint8_t NuAtlas::PackPageFilter(FurrPageFilter filter, size_t elementSize) noexcept
+{
+    uint8_t log2Size = 0;
+    switch (elementSize) {
+    case 1: log2Size = 0; break;
+    case 2: log2Size = 1; break;
+    case 4: log2Size = 2; break;
+    case 8: log2Size = 3; break;
+    default: return 0;
+    }
+    if (filter == FurrPageFilter::None) {
+        return 0;
+    }
+    return static_cast<uint8_t>(static_cast<uint8_t>(filter) | (log2Size << 2));
+}
+
+void NuAtlas::ApplyPageFilter(uint8_t filter, const void* src, void* dst, size_t size) noexcept
+{
+#ifdef FURR_FILTER_X86
+    if (HasAVX2() && ApplyPageFilterAVX2(filter, src, dst, size)) {
+        return;
+    }
+#endif
+    FilterKernels::Run<Best>(filter, src, dst, size, false);
+}
+
+void NuAtlas::RevertPageFilter(uint8_t filter, const void* src, void* dst, size_t size) noexcept
+{
+#ifdef FURR_FILTER_X86
+    if (HasAVX2() && RevertPageFilterAVX2(filter, src, dst, size)) {
+        return;
+    }
+#endif
+    FilterKernels::Run<Best>(filter, src, dst, size, true);
+}
@@ -0,0 +1,46 @@
+/*****************************************************************//**
+ * \file   PageFilter.h
+ * \brief  Reversible filters rearranging typed pages before compression.
+ *
+ * Arrays of floats or wide integers compress poorly as raw bytes: the bytes that barely change
+ * (exponents, high bytes) are interleaved with the noisy ones. The filters group similar bytes or bits
+ * together, or turn slowly changing values into small differences, so LZ4 finds long matches.
+ *
+ * Kernels use AVX2 when the CPU supports it, SSE2 on any other x86-64 CPU and plain C++ elsewhere.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Furrballs.h"
+
+namespace NuAtlas {
+    /**
+     * @brief Packs a filter and its element size into the nibble kept in a page's record header.
+     * Bits 0-1 hold the filter, bits 2-3 the log2 of the element size.
+     * @returns 0 (no filter) if elementSize is not 1, 2, 4 or 8.
+     */
+    uint8_t PackPageFilter(FurrPageFilter filter, size_t elementSize)noexcept;
+
+    inline FurrPageFilter UnpackFilterKind(uint8_t filter) noexcept {
+        return static_cast<FurrPageFilter>(filter & 0x3);
+    }
+
+    inline size_t UnpackElementSize(uint8_t filter) noexcept {
+        return size_t(1) << ((filter >> 2) & 0x3);
+    }
+
+    /**
+     * @brief Filters size bytes of src into dst, the buffers must not overlap.
+     * Bytes past the last whole element (or group of 8 elements for BitShuffle) are copied as they are.
+     * @param filter A value returned by PackPageFilter.
+     */
+    void ApplyPageFilter(uint8_t filter, const void* src, void* dst, size_t size)noexcept;
+
+    /**
+     * @brief Reverts ApplyPageFilter, the buffers must not overlap.
+     */
+    void RevertPageFilter(uint8_t filter, const void* src, void* dst, size_t size)noexcept;
+}
@@ -0,0 +1,103 @@
+/*****************************************************************//**
+ * \file   PageFilterAVX2.cpp
+ * \brief  AVX2 build of the page filter kernels.
+ *
+ * The only file compiled with AVX2 enabled, it is only called once the CPU is known to support it.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+
+#include "PageFilterKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace {
+    /**
+     * @brief AVX2 traits for the filter kernels.
+     * Packs and unpacks work within 128 bit lanes, the 64 bit permutes put bytes back in element order.
+     */
+    struct AVX2 {
+        using Reg = __m256i;
+        static constexpr size_t Width = 32;
+        //A running sum crosses lanes on every step, the SSE2 kernel is as fast.
+        static constexpr bool HasPrefixSum = false;
+
+        static Reg Load(const uint8_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void Store(uint8_t* p, Reg v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static Reg Zero() noexcept { return _mm256_setzero_si256(); }
+        static Reg Or(Reg a, Reg b) noexcept { return _mm256_or_si256(a, b); }
+
+        static void Deinterleave(Reg a, Reg b, Reg& even, Reg& odd) noexcept {
+            const __m256i low = _mm256_set1_epi16(0x00FF);
+            even = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_and_si256(a, low), _mm256_and_si256(b, low)), 0xD8);
+            odd = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)), 0xD8);
+        }
+
+        static void Interleave(Reg a, Reg b, Reg& low, Reg& high) noexcept {
+            a = _mm256_permute4x64_epi64(a, 0xD8);
+            b = _mm256_permute4x64_epi64(b, 0xD8);
+            low = _mm256_unpacklo_epi8(a, b);
+            high = _mm256_unpackhi_epi8(a, b);
+        }
+
+        static uint32_t MoveMask(Reg v) noexcept { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+        static Reg ShiftBitsLeft(Reg v) noexcept { return _mm256_slli_epi16(v, 1); }
+
+        static Reg ExpandBits(uint32_t mask, unsigned bit) noexcept {
+            const __m256i select = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+            const __m256i spread = _mm256_set_epi64x(
+                static_cast<long long>(((mask >> 24) & 0xFF) * 0x0101010101010101ULL),
+                static_cast<long long>(((mask >> 16) & 0xFF) * 0x0101010101010101ULL),
+                static_cast<long long>(((mask >> 8) & 0xFF) * 0x0101010101010101ULL),
+                static_cast<long long>((mask & 0xFF) * 0x0101010101010101ULL));
+            const __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(spread, select), select);
+            return _mm256_and_si256(set, _mm256_set1_epi8(static_cast<char>(1 << bit)));
+        }
+
+        template<size_t E>
+        static Reg Add(Reg a, Reg b) noexcept {
+            if constexpr (E == 1) return _mm256_add_epi8(a, b);
+            else if constexpr (E == 2) return _mm256_add_epi16(a, b);
+            else if constexpr (E == 4) return _mm256_add_epi32(a, b);
+            else return _mm256_add_epi64(a, b);
+        }
+
+        template<size_t E>
+        static Reg Sub(Reg a, Reg b) noexcept {
+            if constexpr (E == 1) return _mm256_sub_epi8(a, b);
+            else if constexpr (E == 2) return _mm256_sub_epi16(a, b);
+            else if constexpr (E == 4) return _mm256_sub_epi32(a, b);
+            else return _mm256_sub_epi64(a, b);
+        }
+    };
+}
+
+bool NuAtlas::ApplyPageFilterAVX2(uint8_t filter, const void* src, void* dst, size_t size) noexcept
+{
+    FilterKernels::Run<AVX2>(filter, src, dst, size, false);
+    return true;
+}
+
+bool NuAtlas::RevertPageFilterAVX2(uint8_t filter, const void* src, void* dst, size_t size) noexcept
+{
+    if ((filter & 0x3) == FilterKernels::KindDelta) {
+        return false;
+    }
+    FilterKernels::Run<AVX2>(filter, src, dst, size, true);
+    return true;
+}
+#else
+bool NuAtlas::ApplyPageFilterAVX2(uint8_t, const void*, void*, size_t) noexcept
+{
+    return false;
+}
+
+bool NuAtlas::RevertPageFilterAVX2(uint8_t, const void*, void*, size_t) noexcept
+{
+    return false;
+}
+#endif
+#endif
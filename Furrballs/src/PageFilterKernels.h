@@ -0,0 +1,331 @@
+/*****************************************************************//**
+ * \file   PageFilterKernels.h
+ * \brief  Filter kernels shared by the scalar, SSE2 and AVX2 builds of PageFilter.
+ *
+ * Kernels are templates over a vector traits class V (void for plain C++) and the element size E.
+ * They are instantiated both in PageFilter.cpp and in PageFilterAVX2.cpp, which is the only
+ * file compiled for AVX2, so this header must stay free of anything but the kernels themselves.
+ *
+ * Filtered layouts, for count elements of E bytes:
+ * - ByteShuffle: byte j of element i goes to j * count + i.
+ * - BitShuffle: bit b of byte j of element i goes to bit i % 8 of byte (j * 8 + b) * (count / 8) + i / 8.
+ * - Delta: element i becomes element i minus element i - 1, wrapping, the first element is kept.
+ *
+ * A traits class provides: Reg, Width (bytes per register), Load, Store, Zero, Or,
+ * Deinterleave (even bytes of a:b, odd bytes of a:b), Interleave (its inverse),
+ * MoveMask (bit 7 of every byte), ShiftBitsLeft (every byte by one bit), ExpandBits (bit i of a mask to byte i),
+ * Add<E>, Sub<E> and, if HasPrefixSum, PrefixSum<E>, Splat<E> and BroadcastLast<E>.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace NuAtlas {
+    namespace FilterKernels {
+        /**
+         * @brief Mirrors FurrPageFilter, which this header cannot include.
+         */
+        enum Kind : uint8_t {
+            KindNone = 0,
+            KindByteShuffle = 1,
+            KindBitShuffle = 2,
+            KindDelta = 3
+        };
+
+        template<size_t E> struct ElementOf;
+        template<> struct ElementOf<1> { using Type = uint8_t; };
+        template<> struct ElementOf<2> { using Type = uint16_t; };
+        template<> struct ElementOf<4> { using Type = uint32_t; };
+        template<> struct ElementOf<8> { using Type = uint64_t; };
+        template<size_t E> using Element = typename ElementOf<E>::Type;
+
+        template<size_t E>
+        inline Element<E> LoadElement(const uint8_t* p) noexcept {
+            Element<E> value;
+            std::memcpy(&value, p, E);
+            return value;
+        }
+
+        template<size_t E>
+        inline void StoreElement(uint8_t* p, Element<E> value) noexcept {
+            std::memcpy(p, &value, E);
+        }
+
+        /**
+         * @brief Loads Width elements and splits them into E registers, register j holding byte j of every element.
+         */
+        template<class V, size_t E>
+        inline void LoadPlanes(const uint8_t* src, typename V::Reg* r) noexcept {
+            for (size_t k = 0; k < E; k++) {
+                r[k] = V::Load(src + k * V::Width);
+            }
+            //log2(E) passes of splitting even and odd bytes leave byte j of every element in register j.
+            for (size_t half = E / 2; half; half /= 2) {
+                typename V::Reg next[E];
+                for (size_t k = 0; k < E / 2; k++) {
+                    V::Deinterleave(r[2 * k], r[2 * k + 1], next[k], next[k + E / 2]);
+                }
+                for (size_t k = 0; k < E; k++) {
+                    r[k] = next[k];
+                }
+            }
+        }
+
+        /**
+         * @brief Reverts LoadPlanes, storing Width elements.
+         */
+        template<class V, size_t E>
+        inline void StorePlanes(typename V::Reg* r, uint8_t* dst) noexcept {
+            for (size_t half = E / 2; half; half /= 2) {
+                typename V::Reg next[E];
+                for (size_t k = 0; k < E / 2; k++) {
+                    V::Interleave(r[k], r[k + E / 2], next[2 * k], next[2 * k + 1]);
+                }
+                for (size_t k = 0; k < E; k++) {
+                    r[k] = next[k];
+                }
+            }
+            for (size_t k = 0; k < E; k++) {
+                V::Store(dst + k * V::Width, r[k]);
+            }
+        }
+
+        template<class V, size_t E>
+        void Shuffle(const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            size_t i = 0;
+            if constexpr (!std::is_void_v<V>) {
+                for (; i + V::Width <= count; i += V::Width) {
+                    typename V::Reg r[E];
+                    LoadPlanes<V, E>(src + i * E, r);
+                    for (size_t j = 0; j < E; j++) {
+                        V::Store(dst + j * count + i, r[j]);
+                    }
+                }
+            }
+            for (; i < count; i++) {
+                for (size_t j = 0; j < E; j++) {
+                    dst[j * count + i] = src[i * E + j];
+                }
+            }
+        }
+
+        template<class V, size_t E>
+        void Unshuffle(const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            size_t i = 0;
+            if constexpr (!std::is_void_v<V>) {
+                for (; i + V::Width <= count; i += V::Width) {
+                    typename V::Reg r[E];
+                    for (size_t j = 0; j < E; j++) {
+                        r[j] = V::Load(src + j * count + i);
+                    }
+                    StorePlanes<V, E>(r, dst + i * E);
+                }
+            }
+            for (; i < count; i++) {
+                for (size_t j = 0; j < E; j++) {
+                    dst[i * E + j] = src[j * count + i];
+                }
+            }
+        }
+
+        /**
+         * @param count A multiple of 8.
+         */
+        template<class V, size_t E>
+        void BitShuffle(const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            const size_t row = count / 8;
+            size_t i = 0;
+            if constexpr (!std::is_void_v<V>) {
+                for (; i + V::Width <= count; i += V::Width) {
+                    typename V::Reg r[E];
+                    LoadPlanes<V, E>(src + i * E, r);
+                    for (size_t j = 0; j < E; j++) {
+                        //Each shift brings the next lower bit of every byte to bit 7, where MoveMask picks it.
+                        typename V::Reg x = r[j];
+                        for (size_t b = 8; b-- > 0;) {
+                            const uint32_t mask = V::MoveMask(x);
+                            std::memcpy(dst + (j * 8 + b) * row + i / 8, &mask, V::Width / 8);
+                            x = V::ShiftBitsLeft(x);
+                        }
+                    }
+                }
+            }
+            for (; i < count; i += 8) {
+                for (size_t j = 0; j < E; j++) {
+                    for (size_t b = 0; b < 8; b++) {
+                        uint8_t bits = 0;
+                        for (size_t t = 0; t < 8; t++) {
+                            bits |= static_cast<uint8_t>(((src[(i + t) * E + j] >> b) & 1) << t);
+                        }
+                        dst[(j * 8 + b) * row + i / 8] = bits;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @param count A multiple of 8.
+         */
+        template<class V, size_t E>
+        void BitUnshuffle(const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            const size_t row = count / 8;
+            size_t i = 0;
+            if constexpr (!std::is_void_v<V>) {
+                for (; i + V::Width <= count; i += V::Width) {
+                    typename V::Reg r[E];
+                    for (size_t j = 0; j < E; j++) {
+                        typename V::Reg x = V::Zero();
+                        for (unsigned b = 0; b < 8; b++) {
+                            uint32_t mask = 0;
+                            std::memcpy(&mask, src + (j * 8 + b) * row + i / 8, V::Width / 8);
+                            x = V::Or(x, V::ExpandBits(mask, b));
+                        }
+                        r[j] = x;
+                    }
+                    StorePlanes<V, E>(r, dst + i * E);
+                }
+            }
+            for (; i < count; i += 8) {
+                for (size_t j = 0; j < E; j++) {
+                    uint8_t bytes[8] = {};
+                    for (size_t b = 0; b < 8; b++) {
+                        const uint8_t bits = src[(j * 8 + b) * row + i / 8];
+                        for (size_t t = 0; t < 8; t++) {
+                            bytes[t] |= static_cast<uint8_t>(((bits >> t) & 1) << b);
+                        }
+                    }
+                    for (size_t t = 0; t < 8; t++) {
+                        dst[(i + t) * E + j] = bytes[t];
+                    }
+                }
+            }
+        }
+
+        template<class V, size_t E>
+        void Delta(const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            if (!count) {
+                return;
+            }
+            std::memcpy(dst, src, E);
+            size_t i = 1;
+            if constexpr (!std::is_void_v<V>) {
+                //Loading one element back gives every lane its predecessor without any shuffling.
+                constexpr size_t step = V::Width / E;
+                for (; i + step <= count; i += step) {
+                    V::Store(dst + i * E, V::template Sub<E>(V::Load(src + i * E), V::Load(src + (i - 1) * E)));
+                }
+            }
+            for (; i < count; i++) {
+                StoreElement<E>(dst + i * E, static_cast<Element<E>>(
+                    LoadElement<E>(src + i * E) - LoadElement<E>(src + (i - 1) * E)));
+            }
+        }
+
+        template<class V, size_t E>
+        void Undelta(const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            if (!count) {
+                return;
+            }
+            std::memcpy(dst, src, E);
+            size_t i = 1;
+            if constexpr (!std::is_void_v<V>) {
+                if constexpr (V::HasPrefixSum) {
+                    constexpr size_t step = V::Width / E;
+                    typename V::Reg carry = V::template Splat<E>(LoadElement<E>(dst));
+                    for (; i + step <= count; i += step) {
+                        const typename V::Reg x = V::template Add<E>(V::template PrefixSum<E>(V::Load(src + i * E)), carry);
+                        V::Store(dst + i * E, x);
+                        carry = V::template BroadcastLast<E>(x);
+                    }
+                }
+            }
+            for (; i < count; i++) {
+                StoreElement<E>(dst + i * E, static_cast<Element<E>>(
+                    LoadElement<E>(dst + (i - 1) * E) + LoadElement<E>(src + i * E)));
+            }
+        }
+
+        template<class V, size_t E>
+        void ApplyElements(uint8_t kind, const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            switch (kind) {
+            case KindByteShuffle:
+                Shuffle<V, E>(src, dst, count);
+                break;
+            case KindBitShuffle:
+                BitShuffle<V, E>(src, dst, count);
+                break;
+            case KindDelta:
+                Delta<V, E>(src, dst, count);
+                break;
+            default:
+                std::memcpy(dst, src, count * E);
+                break;
+            }
+        }
+
+        template<class V, size_t E>
+        void RevertElements(uint8_t kind, const uint8_t* src, uint8_t* dst, size_t count) noexcept {
+            switch (kind) {
+            case KindByteShuffle:
+                Unshuffle<V, E>(src, dst, count);
+                break;
+            case KindBitShuffle:
+                BitUnshuffle<V, E>(src, dst, count);
+                break;
+            case KindDelta:
+                Undelta<V, E>(src, dst, count);
+                break;
+            default:
+                std::memcpy(dst, src, count * E);
+                break;
+            }
+        }
+
+        /**
+         * @brief Runs a packed filter (see PackPageFilter) over size bytes.
+         * @param revert Reverts the filter instead of applying it.
+         */
+        template<class V>
+        void Run(uint8_t filter, const void* source, void* destination, size_t size, bool revert) noexcept {
+            const uint8_t* src = static_cast<const uint8_t*>(source);
+            uint8_t* dst = static_cast<uint8_t*>(destination);
+            const uint8_t kind = filter & 0x3;
+            const size_t elementSize = size_t(1) << ((filter >> 2) & 0x3);
+            size_t count = size / elementSize;
+            if (kind == KindBitShuffle) {
+                count -= count % 8;
+            }
+            auto run = [&](auto elementTag) {
+                constexpr size_t E = decltype(elementTag)::value;
+                if (revert) {
+                    RevertElements<V, E>(kind, src, dst, count);
+                }
+                else {
+                    ApplyElements<V, E>(kind, src, dst, count);
+                }
+            };
+            switch (elementSize) {
+            case 1: run(std::integral_constant<size_t, 1>()); break;
+            case 2: run(std::integral_constant<size_t, 2>()); break;
+            case 4: run(std::integral_constant<size_t, 4>()); break;
+            default: run(std::integral_constant<size_t, 8>()); break;
+            }
+            const size_t filtered = count * elementSize;
+            std::memcpy(dst + filtered, src + filtered, size - filtered);
+        }
+    }
+
+#if defined(__x86_64__) || defined(_M_X64)
+    /**
+     * @brief AVX2 builds of ApplyPageFilter and RevertPageFilter, defined in PageFilterAVX2.cpp.
+     * @returns false if the filter has no AVX2 kernel (or the file was not built for AVX2) and nothing was done.
+     */
+    bool ApplyPageFilterAVX2(uint8_t filter, const void* src, void* dst, size_t size)noexcept;
+    bool RevertPageFilterAVX2(uint8_t filter, const void* src, void* dst, size_t size)noexcept;
+#endif
+}
@@ -0,0 +1,125 @@
+/*****************************************************************//**
+ * \file   PageFormat.h
+ * \brief  On-disk layout of the pages stored by a FurrBall.
+ *
+ * Every page is stored under an 8 byte big-endian key (its page address) and its value
+ * starts with a small record header followed by the page bytes.
+ * Large data is stored under a 9 byte key, the LargeDataPrefix followed by its big-endian handle.
+ * Ball metadata is stored under the MetadataPrefix followed by its name, sorting between pages and large data.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <string>
+#include <rocksdb/slice.h>
+
+namespace NuAtlas {
+    constexpr size_t PageKeySize = sizeof(uint64_t);
+
+    /**
+     * @brief Encodes a page address big-endian so pages are ordered by address in the DB.
+     */
+    inline void EncodePageKey(size_t pageAddress, char* out) noexcept {
+        for (size_t i = 0; i < PageKeySize; i++) {
+            out[i] = static_cast<char>((static_cast<uint64_t>(pageAddress) >> (8 * (PageKeySize - 1 - i))) & 0xFF);
+        }
+    }
+
+    inline size_t DecodePageKey(const rocksdb::Slice& key) noexcept {
+        uint64_t address = 0;
+        for (size_t i = 0; i < PageKeySize && i < key.size(); i++) {
+            address = (address << 8) | static_cast<unsigned char>(key.data()[i]);
+        }
+        return static_cast<size_t>(address);
+    }
+
+    constexpr char LargeDataPrefix = '\xFF';
+    constexpr size_t LargeDataKeySize = 1 + sizeof(uint64_t);
+
+    inline void EncodeLargeDataKey(uint64_t handle, char* out) noexcept {
+        out[0] = LargeDataPrefix;
+        EncodePageKey(static_cast<size_t>(handle), out + 1);
+    }
+
+    inline bool IsLargeDataKey(const rocksdb::Slice& key) noexcept {
+        return key.size() == LargeDataKeySize && key.data()[0] == LargeDataPrefix;
+    }
+
+    inline uint64_t DecodeLargeDataKey(const rocksdb::Slice& key) noexcept {
+        return DecodePageKey(rocksdb::Slice(key.data() + 1, key.size() - 1));
+    }
+
+    constexpr char MetadataPrefix = '\xFE';
+
+    /**
+     * @brief Key of a metadata entry, names must not be 7 or 8 bytes long to stay apart from page and large data keys.
+     */
+    inline std::string MetadataKey(const char* name) {
+        return std::string(1, MetadataPrefix) + name;
+    }
+
+    /**
+     * @brief Key of the ball's page compression dictionary.
+     */
+    constexpr const char* PageDictionaryName = "PageDictionary";
+
+    /**
+     * @brief Header prepended to every stored page.
+     */
+    struct PageRecordHeader {
+        /**
+         * @brief Unix time in seconds after which the record is expired, 0 if it never expires.
+         */
+        uint64_t ExpiresAt = 0;
+        /**
+         * @brief PageCodec the page bytes following the header are encoded with.
+         */
+        uint8_t Codec = 0;
+        /**
+         * @brief The page's filter as packed by PackPageFilter, applied before compression.
+         * Raw pages are stored unfiltered, the filter is kept as the page's hint.
+         */
+        uint8_t Filter = 0;
+    };
+    /**
+     * @brief Codec and filter share a byte, the codec in the low nibble.
+     */
+    constexpr size_t PageRecordHeaderSize = sizeof(uint64_t) + sizeof(uint8_t);
+
+    inline void EncodeRecordHeader(const PageRecordHeader& header, char* out) noexcept {
+        for (size_t i = 0; i < sizeof(uint64_t); i++) {
+            out[i] = static_cast<char>((header.ExpiresAt >> (8 * i)) & 0xFF);
+        }
+        out[sizeof(uint64_t)] = static_cast<char>((header.Codec & 0x0F) | (header.Filter << 4));
+    }
+
+    /**
+     * @return false if the value is too short to hold a header.
+     */
+    inline bool DecodeRecordHeader(const rocksdb::Slice& value, PageRecordHeader& header) noexcept {
+        if (value.size() < PageRecordHeaderSize) {
+            return false;
+        }
+        header.ExpiresAt = 0;
+        for (size_t i = 0; i < sizeof(uint64_t); i++) {
+            header.ExpiresAt |= static_cast<uint64_t>(static_cast<unsigned char>(value.data()[i])) << (8 * i);
+        }
+        const uint8_t codecAndFilter = static_cast<uint8_t>(value.data()[sizeof(uint64_t)]);
+        header.Codec = codecAndFilter & 0x0F;
+        header.Filter = codecAndFilter >> 4;
+        return true;
+    }
+
+    inline uint64_t NowSeconds() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    inline bool IsExpired(const PageRecordHeader& header, uint64_t now) noexcept {
+        return header.ExpiresAt != 0 && header.ExpiresAt <= now;
+    }
+}
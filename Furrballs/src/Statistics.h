@@ -0,0 +1,188 @@
+/*****************************************************************//**
+ * \file   Statistics.h
+ * \brief  Counters, perf context sampling and RocksDB statistics behind FurrStats.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <rocksdb/statistics.h>
+#include <rocksdb/perf_context.h>
+#include <rocksdb/perf_level.h>
+#include "Furrballs.h"
+#include "ThreadPolicy.h"
+
+namespace NuAtlas {
+    /**
+     * @brief Lock-free accumulators behind FurrStats, only the slowest sample is guarded.
+     */
+    struct StatCounters {
+        std::atomic<size_t> PageHits{ 0 };
+        std::atomic<size_t> PageMisses{ 0 };
+        std::atomic<size_t> CoalescedMisses{ 0 };
+        std::atomic<size_t> Evictions{ 0 };
+        std::atomic<size_t> BackgroundEvictions{ 0 };
+        std::atomic<size_t> WriteBacks{ 0 };
+        std::atomic<size_t> RecompressedPages{ 0 };
+        std::atomic<size_t> RecompressedBytesSaved{ 0 };
+        CoreBusyTime CoreBusy;
+
+        std::atomic<uint64_t> LoadCounter{ 0 };
+        std::atomic<uint64_t> SampledLoads{ 0 };
+        struct {
+            std::atomic<uint64_t> TotalNanos{ 0 };
+            std::atomic<uint64_t> MemtableNanos{ 0 };
+            std::atomic<uint64_t> SstNanos{ 0 };
+            std::atomic<uint64_t> BlockReadNanos{ 0 };
+            std::atomic<uint64_t> DecompressNanos{ 0 };
+            std::atomic<uint64_t> BlockReadBytes{ 0 };
+            std::atomic<uint64_t> BlockReads{ 0 };
+            std::atomic<uint64_t> BlockCacheHits{ 0 };
+            std::atomic<uint64_t> BloomUseful{ 0 };
+            std::atomic<uint64_t> BloomPositive{ 0 };
+        } Total;
+        std::mutex SlowestMutex;
+        FurrStats::LoadBreakdown Slowest;
+
+        void Accumulate(const FurrStats::LoadBreakdown& sample) noexcept {
+            SampledLoads.fetch_add(1, std::memory_order_relaxed);
+            Total.TotalNanos.fetch_add(sample.TotalNanos, std::memory_order_relaxed);
+            Total.MemtableNanos.fetch_add(sample.MemtableNanos, std::memory_order_relaxed);
+            Total.SstNanos.fetch_add(sample.SstNanos, std::memory_order_relaxed);
+            Total.BlockReadNanos.fetch_add(sample.BlockReadNanos, std::memory_order_relaxed);
+            Total.DecompressNanos.fetch_add(sample.DecompressNanos, std::memory_order_relaxed);
+            Total.BlockReadBytes.fetch_add(sample.BlockReadBytes, std::memory_order_relaxed);
+            Total.BlockReads.fetch_add(sample.BlockReads, std::memory_order_relaxed);
+            Total.BlockCacheHits.fetch_add(sample.BlockCacheHits, std::memory_order_relaxed);
+            Total.BloomUseful.fetch_add(sample.BloomUseful, std::memory_order_relaxed);
+            Total.BloomPositive.fetch_add(sample.BloomPositive, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(SlowestMutex);
+            if (sample.TotalNanos > Slowest.TotalNanos) {
+                Slowest = sample;
+            }
+        }
+
+        void Fill(FurrStats& stats) noexcept {
+            stats.PageHits = PageHits.load(std::memory_order_relaxed);
+            stats.PageMisses = PageMisses.load(std::memory_order_relaxed);
+            stats.CoalescedMisses = CoalescedMisses.load(std::memory_order_relaxed);
+            stats.Evictions = Evictions.load(std::memory_order_relaxed);
+            stats.BackgroundEvictions = BackgroundEvictions.load(std::memory_order_relaxed);
+            stats.WriteBacks = WriteBacks.load(std::memory_order_relaxed);
+            stats.RecompressedPages = RecompressedPages.load(std::memory_order_relaxed);
+            stats.RecompressedBytesSaved = RecompressedBytesSaved.load(std::memory_order_relaxed);
+            CoreBusy.Fill(stats.CoreBusyNanos);
+            stats.Sampled.SampledLoads = SampledLoads.load(std::memory_order_relaxed);
+            stats.Sampled.Total.TotalNanos = Total.TotalNanos.load(std::memory_order_relaxed);
+            stats.Sampled.Total.MemtableNanos = Total.MemtableNanos.load(std::memory_order_relaxed);
+            stats.Sampled.Total.SstNanos = Total.SstNanos.load(std::memory_order_relaxed);
+            stats.Sampled.Total.BlockReadNanos = Total.BlockReadNanos.load(std::memory_order_relaxed);
+            stats.Sampled.Total.DecompressNanos = Total.DecompressNanos.load(std::memory_order_relaxed);
+            stats.Sampled.Total.BlockReadBytes = Total.BlockReadBytes.load(std::memory_order_relaxed);
+            stats.Sampled.Total.BlockReads = Total.BlockReads.load(std::memory_order_relaxed);
+            stats.Sampled.Total.BlockCacheHits = Total.BlockCacheHits.load(std::memory_order_relaxed);
+            stats.Sampled.Total.BloomUseful = Total.BloomUseful.load(std::memory_order_relaxed);
+            stats.Sampled.Total.BloomPositive = Total.BloomPositive.load(std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(SlowestMutex);
+            stats.Sampled.Slowest = Slowest;
+        }
+    };
+
+    /**
+     * @brief Profiles the page load running in its scope with PerfContext, if the load is picked by the sampling interval.
+     *
+     * PerfContext is thread local, the sample must begin and end on the same thread.
+     */
+    class PerfSample final {
+    private:
+        StatCounters* Counters = nullptr;
+        rocksdb::PerfLevel PreviousLevel = rocksdb::PerfLevel::kDisable;
+        std::chrono::steady_clock::time_point Start;
+        uint64_t DecodeNanos = 0;
+
+    public:
+        PerfSample(StatCounters& counters, size_t interval) noexcept {
+            if (!interval || counters.LoadCounter.fetch_add(1, std::memory_order_relaxed) % interval) {
+                return;
+            }
+            Counters = &counters;
+            PreviousLevel = rocksdb::GetPerfLevel();
+            rocksdb::SetPerfLevel(rocksdb::PerfLevel::kEnableTimeExceptForMutex);
+            rocksdb::get_perf_context()->Reset();
+            Start = std::chrono::steady_clock::now();
+        }
+        PerfSample(const PerfSample&) = delete;
+        PerfSample& operator=(const PerfSample&) = delete;
+
+        /**
+         * @brief The current time if the load is sampled, a default time point otherwise so unsampled loads read no clock.
+         */
+        std::chrono::steady_clock::time_point Now() const noexcept {
+            return Counters ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        }
+
+        /**
+         * @brief Counts the time since start, taken from Now(), as decompression done by the ball's page codec.
+         */
+        void AddDecompressTime(std::chrono::steady_clock::time_point start) noexcept {
+            if (Counters) {
+                DecodeNanos += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+        }
+
+        ~PerfSample() {
+            if (!Counters) {
+                return;
+            }
+            const rocksdb::PerfContext* perf = rocksdb::get_perf_context();
+            FurrStats::LoadBreakdown sample;
+            sample.TotalNanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - Start).count());
+            sample.MemtableNanos = perf->get_from_memtable_time;
+            sample.SstNanos = perf->get_from_output_files_time;
+            sample.BlockReadNanos = perf->block_read_time;
+            sample.DecompressNanos = perf->block_decompress_time + DecodeNanos;
+            sample.BlockReadBytes = perf->block_read_byte;
+            sample.BlockReads = perf->block_read_count;
+            sample.BlockCacheHits = perf->block_cache_hit_count;
+            sample.BloomUseful = perf->bloom_sst_miss_count;
+            sample.BloomPositive = perf->bloom_sst_hit_count;
+            rocksdb::SetPerfLevel(PreviousLevel);
+            Counters->Accumulate(sample);
+        }
+    };
+
+    inline FurrStats::Histogram ReadHistogram(const rocksdb::Statistics& statistics, uint32_t type) noexcept {
+        rocksdb::HistogramData data{};
+        statistics.histogramData(type, &data);
+        FurrStats::Histogram histogram;
+        histogram.Count = data.count;
+        histogram.Average = data.average;
+        histogram.Median = data.median;
+        histogram.P95 = data.percentile95;
+        histogram.P99 = data.percentile99;
+        histogram.Max = data.max;
+        return histogram;
+    }
+
+    inline void FillDBStats(const rocksdb::Statistics& statistics, FurrStats& stats) noexcept {
+        stats.DB.BlockCacheHits = statistics.getTickerCount(rocksdb::BLOCK_CACHE_HIT);
+        stats.DB.BlockCacheMisses = statistics.getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+        stats.DB.BloomUseful = statistics.getTickerCount(rocksdb::BLOOM_FILTER_USEFUL);
+        stats.DB.BloomPositive = statistics.getTickerCount(rocksdb::BLOOM_FILTER_FULL_POSITIVE);
+        stats.DB.BloomTruePositive = statistics.getTickerCount(rocksdb::BLOOM_FILTER_FULL_TRUE_POSITIVE);
+        stats.DB.BytesRead = statistics.getTickerCount(rocksdb::BYTES_READ);
+        stats.DB.BytesWritten = statistics.getTickerCount(rocksdb::BYTES_WRITTEN);
+        stats.DB.CompactionReadBytes = statistics.getTickerCount(rocksdb::COMPACT_READ_BYTES);
+        stats.DB.CompactionWriteBytes = statistics.getTickerCount(rocksdb::COMPACT_WRITE_BYTES);
+        stats.DB.CompactionDroppedPages = statistics.getTickerCount(rocksdb::COMPACTION_KEY_DROP_USER);
+        stats.DB.StallMicros = statistics.getTickerCount(rocksdb::STALL_MICROS);
+        stats.DB.GetMicros = ReadHistogram(statistics, rocksdb::DB_GET);
+        stats.DB.WriteMicros = ReadHistogram(statistics, rocksdb::DB_WRITE);
+        stats.DB.SstReadMicros = ReadHistogram(statistics, rocksdb::SST_READ_MICROS);
+    }
+}
@@ -0,0 +1,107 @@
+/*****************************************************************//**
+ * \file   ThreadPolicy.cpp
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+
+#include "ThreadPolicy.h"
+#include <thread>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace NuAtlas;
+
+bool NuAtlas::ApplyThreadPolicy(const FurrThreadPolicy& policy) noexcept
+{
+    bool applied = true;
+#ifdef _WIN32
+    if (policy.AffinityMask) {
+        applied = SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(policy.AffinityMask)) != 0;
+    }
+    //Windows has no batch class, the policy and nice value map to thread priorities.
+    int priority = THREAD_PRIORITY_NORMAL;
+    if (policy.Policy == FurrSchedulingPolicy::Idle) {
+        priority = THREAD_PRIORITY_IDLE;
+    }
+    else if (policy.Nice >= 10) {
+        priority = THREAD_PRIORITY_LOWEST;
+    }
+    else if (policy.Nice > 0 || policy.Policy == FurrSchedulingPolicy::Batch) {
+        priority = THREAD_PRIORITY_BELOW_NORMAL;
+    }
+    if (priority != THREAD_PRIORITY_NORMAL) {
+        applied = SetThreadPriority(GetCurrentThread(), priority) && applied;
+    }
+#else
+#ifdef __linux__
+    if (policy.AffinityMask) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (size_t core = 0; core < 64; core++) {
+            if (policy.AffinityMask & (uint64_t(1) << core)) {
+                CPU_SET(core, &set);
+            }
+        }
+        //pid 0 is the calling thread.
+        applied = sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+    if (policy.Policy != FurrSchedulingPolicy::Normal) {
+        sched_param param{};
+        const int linuxPolicy = policy.Policy == FurrSchedulingPolicy::Idle ? SCHED_IDLE : SCHED_BATCH;
+        applied = sched_setscheduler(0, linuxPolicy, &param) == 0 && applied;
+    }
+#endif
+    //On Linux the nice value is per thread, who = 0 targets the calling thread. SCHED_IDLE ignores it.
+    if (policy.Nice && policy.Policy != FurrSchedulingPolicy::Idle) {
+        applied = setpriority(PRIO_PROCESS, 0, policy.Nice) == 0 && applied;
+    }
+#endif
+    return applied;
+}
+
+size_t NuAtlas::CurrentCore() noexcept
+{
+#ifdef _WIN32
+    return GetCurrentProcessorNumber();
+#elif defined(__linux__)
+    const int core = sched_getcpu();
+    return core < 0 ? 0 : static_cast<size_t>(core);
+#else
+    return 0;
+#endif
+}
+
+size_t NuAtlas::CoreCount(const FurrThreadPolicy& policy, size_t fallback) noexcept
+{
+    if (!policy.AffinityMask) {
+        return fallback;
+    }
+    size_t count = 0;
+    for (uint64_t mask = policy.AffinityMask; mask; mask &= mask - 1) {
+        count++;
+    }
+    return count;
+}
+
+NuAtlas::CoreBusyTime::CoreBusyTime() : Count((std::max)(std::thread::hardware_concurrency(), 1u))
+{
+    Slots.reset(new Slot[Count]);
+}
+
+void NuAtlas::CoreBusyTime::Record(uint64_t nanos) noexcept
+{
+    Slots[CurrentCore() % Count].Nanos.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+void NuAtlas::CoreBusyTime::Fill(std::vector<uint64_t>& nanos) const
+{
+    nanos.resize(Count);
+    for (size_t i = 0; i < Count; i++) {
+        nanos[i] = Slots[i].Nanos.load(std::memory_order_relaxed);
+    }
+}
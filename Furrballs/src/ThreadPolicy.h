@@ -0,0 +1,54 @@
+/*****************************************************************//**
+ * \file   ThreadPolicy.h
+ * \brief  Core pinning and scheduling policy of FurrBall's own threads, and the busy time they spend per core.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Furrballs.h"
+
+namespace NuAtlas {
+    /**
+     * @brief Applies policy to the calling thread.
+     * @returns false if the OS refused part of it, e.g. a mask without online cores.
+     */
+    bool ApplyThreadPolicy(const FurrThreadPolicy& policy) noexcept;
+
+    /**
+     * @brief The core the calling thread runs on, 0 where it cannot be queried.
+     */
+    size_t CurrentCore() noexcept;
+
+    /**
+     * @brief Cores a policy allows, or fallback if its mask is 0.
+     */
+    size_t CoreCount(const FurrThreadPolicy& policy, size_t fallback) noexcept;
+
+    /**
+     * @brief Busy nanoseconds of FurrBall's threads per core, each core on its own cache line.
+     */
+    class CoreBusyTime final {
+    private:
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> Nanos{ 0 };
+        };
+        std::unique_ptr<Slot[]> Slots;
+        size_t Count;
+
+    public:
+        CoreBusyTime();
+
+        /**
+         * @brief Adds nanos to the core the calling thread runs on.
+         */
+        void Record(uint64_t nanos) noexcept;
+
+        void Fill(std::vector<uint64_t>& nanos) const;
+    };
+}
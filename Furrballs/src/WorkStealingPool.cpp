@@ -0,0 +1,255 @@
+/*****************************************************************//**
+ * \file   WorkStealingPool.cpp
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+
+#include "WorkStealingPool.h"
+#include <chrono>
+#include "Futex.h"
+#include "ThreadPolicy.h"
+
+using namespace NuAtlas;
+
+namespace {
+    struct WorkerIdentity {
+        const WorkStealingPool* Pool = nullptr;
+        size_t Index = 0;
+    };
+    thread_local WorkerIdentity CurrentWorker;
+    /**
+     * @brief Per-thread xorshift state picking the first victim to steal from.
+     */
+    thread_local uint32_t VictimSeed = 0x9E3779B9u;
+
+    /**
+     * @brief Rounds of looking for work before an idle worker parks.
+     */
+    constexpr int SpinRounds = 64;
+}
+
+NuAtlas::WorkStealingPool::WorkStealingPool(size_t threadCount, std::function<void()> onWorkerStart, CoreBusyTime* busyTime)
+    : OnWorkerStart(std::move(onWorkerStart)), BusyTime(busyTime)
+{
+    threadCount = (std::max)(threadCount, size_t(1));
+    Workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        Workers.emplace_back(new Worker());
+    }
+    //Every deque exists before any worker can try to steal from it.
+    for (size_t i = 0; i < threadCount; i++) {
+        Workers[i]->Thread = std::thread([this, i] { WorkerLoop(i); });
+    }
+}
+
+void NuAtlas::WorkStealingPool::Inject(Task* tasks, size_t count, TaskPriority priority) noexcept
+{
+    MPMCQueue<Task>& queue = priority == TaskPriority::High ? HighPriority
+        : priority == TaskPriority::Low ? LowPriority : Injection;
+    while (count) {
+        const size_t pushed = queue.PushBatch(tasks, count);
+        tasks += pushed;
+        count -= pushed;
+        if (count) {
+            //Full, drain it rather than grow it.
+            Wake(Workers.size());
+            if (!RunPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+void NuAtlas::WorkStealingPool::Submit(Task task, TaskPriority priority, uint64_t)
+{
+    if (CurrentWorker.Pool == this && priority != TaskPriority::Low) {
+        Workers[CurrentWorker.Index]->Deque.Push(new Task(std::move(task)));
+    }
+    else {
+        Inject(&task, 1, priority);
+    }
+    Wake(1);
+}
+
+void NuAtlas::WorkStealingPool::SubmitBatch(Task* tasks, size_t count, TaskPriority priority, uint64_t)
+{
+    if (CurrentWorker.Pool == this && priority != TaskPriority::Low) {
+        for (size_t i = 0; i < count; i++) {
+            Workers[CurrentWorker.Index]->Deque.Push(new Task(std::move(tasks[i])));
+        }
+    }
+    else {
+        Inject(tasks, count, priority);
+    }
+    Wake(count);
+}
+
+void NuAtlas::WorkStealingPool::Wake(size_t count) noexcept
+{
+    //Pairs with the fence of a parking worker: either it sees the new task or we see it sleeping.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!count || !Sleepers.load(std::memory_order_relaxed)) {
+        return;
+    }
+    WakeEpoch.fetch_add(1, std::memory_order_release);
+    FutexWake(WakeEpoch, count >= Workers.size() ? 0 : static_cast<uint32_t>(count));
+}
+
+bool NuAtlas::WorkStealingPool::HasVisibleWork() const noexcept
+{
+    if (!HighPriority.Empty() || !Injection.Empty() || !LowPriority.Empty()) {
+        return true;
+    }
+    for (const auto& worker : Workers) {
+        if (!worker->Deque.Empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NuAtlas::WorkStealingPool::TakeInjected(MPMCQueue<Task>& queue, size_t self, Task& task) noexcept
+{
+    //Only a worker has a deque to keep the rest of a batch in.
+    if (self >= Workers.size()) {
+        return queue.TryPop(task);
+    }
+    Task batch[InjectionBatch];
+    const size_t popped = queue.PopBatch(batch, InjectionBatch);
+    if (!popped) {
+        return false;
+    }
+    task = std::move(batch[0]);
+    //Pushed last first, so popping them back keeps the injection order. Idle workers steal them meanwhile.
+    for (size_t i = popped - 1; i > 0; i--) {
+        Workers[self]->Deque.Push(new Task(std::move(batch[i])));
+    }
+    Wake(popped - 1);
+    return true;
+}
+
+bool NuAtlas::WorkStealingPool::FindTask(size_t self, Task& task) noexcept
+{
+    if (self < Workers.size()) {
+        if (Task* item = Workers[self]->Deque.Pop()) {
+            task = std::move(*item);
+            delete item;
+            return true;
+        }
+    }
+    if (TakeInjected(HighPriority, self, task) || TakeInjected(Injection, self, task)) {
+        return true;
+    }
+    VictimSeed ^= VictimSeed << 13;
+    VictimSeed ^= VictimSeed >> 17;
+    VictimSeed ^= VictimSeed << 5;
+    const size_t count = Workers.size();
+    const size_t start = VictimSeed % count;
+    for (size_t i = 0; i < count; i++) {
+        const size_t victim = (start + i) % count;
+        if (victim == self) {
+            continue;
+        }
+        if (Task* item = Workers[victim]->Deque.Steal()) {
+            task = std::move(*item);
+            delete item;
+            return true;
+        }
+    }
+    return LowPriority.TryPop(task);
+}
+
+void NuAtlas::WorkStealingPool::WorkerLoop(size_t index) noexcept
+{
+    CurrentWorker.Pool = this;
+    CurrentWorker.Index = index;
+    VictimSeed ^= static_cast<uint32_t>(index * 0x85EBCA6Bu);
+    if (OnWorkerStart) {
+        OnWorkerStart();
+    }
+    Task task;
+    while (true) {
+        bool found = false;
+        for (int spin = 0; !found && spin < SpinRounds && !Stopping.load(std::memory_order_relaxed); spin++) {
+            found = FindTask(index, task);
+            if (!found) {
+                std::this_thread::yield();
+            }
+        }
+        if (found) {
+            if (BusyTime) {
+                const auto start = std::chrono::steady_clock::now();
+                task();
+                BusyTime->Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+            }
+            else {
+                task();
+            }
+            //What the task captured goes now, not when the next one replaces it.
+            task = nullptr;
+            continue;
+        }
+        if (Stopping.load(std::memory_order_acquire)) {
+            return;
+        }
+        //Read before checking for work, a wake-up after the check changes it and the wait returns at once.
+        const uint32_t epoch = WakeEpoch.load(std::memory_order_acquire);
+        Sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!HasVisibleWork() && !Stopping.load(std::memory_order_relaxed)) {
+            FutexWait(WakeEpoch, epoch);
+        }
+        Sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool NuAtlas::WorkStealingPool::RunPendingTask() noexcept
+{
+    Task task;
+    if (!FindTask(CurrentWorker.Pool == this ? CurrentWorker.Index : Workers.size(), task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+NuAtlas::WorkStealingPool::~WorkStealingPool()
+{
+    Stopping.store(true, std::memory_order_seq_cst);
+    WakeEpoch.fetch_add(1, std::memory_order_release);
+    FutexWake(WakeEpoch, 0);
+    for (auto& worker : Workers) {
+        worker->Thread.join();
+    }
+    //Tasks left in the rings are destroyed with them.
+    for (auto& worker : Workers) {
+        while (Task* task = worker->Deque.Pop()) {
+            delete task;
+        }
+    }
+}
+
+void NuAtlas::TaskGroup::Run(IExecutor::Task task)
+{
+    if (!Executor) {
+        task();
+        return;
+    }
+    Pending.fetch_add(1, std::memory_order_relaxed);
+    Executor->Submit([this, task = std::move(task)] {
+        task();
+        //Last touch of the group, Wait may return and destroy it right after.
+        Pending.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+void NuAtlas::TaskGroup::Wait() noexcept
+{
+    while (Pending.load(std::memory_order_acquire)) {
+        if (!Executor->RunPendingTask()) {
+            std::this_thread::yield();
+        }
+    }
+}
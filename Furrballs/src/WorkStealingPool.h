@@ -0,0 +1,258 @@
+/*****************************************************************//**
+ * \file   WorkStealingPool.h
+ * \brief  Work-stealing thread pool, the executor of burst mode work unless FurrConfig::Executor is set.
+ *
+ * Every worker owns a Chase-Lev deque: it pushes and pops its own tasks at the bottom while idle workers
+ * steal from the top, so tasks spawned by a task stay on the worker that spawned them.
+ * Tasks submitted from outside the pool go through lock-free injection rings, one per priority, stored by value
+ * so submitting allocates nothing. An idle worker takes a batch of them at once and keeps the rest in its deque.
+ * Idle workers spin briefly, then park on a futex that submitters only touch if someone sleeps.
+ * Low priority tasks are taken only when nothing else can be found or stolen.
+ *
+ * \author The Sphynx
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <IExecutor.h>
+#include "MPMCQueue.h"
+
+namespace NuAtlas {
+    class CoreBusyTime;
+
+    /**
+     * @brief Chase-Lev deque of pointers, with the memory orderings of Lê et al. (PPoPP 2013).
+     * Push and Pop are owner-only, Steal can be called from any thread.
+     */
+    template<class T>
+    class WorkStealingDeque final {
+        static_assert(std::is_pointer<T>::value, "The deque holds pointers, nullptr means empty.");
+    private:
+        struct Ring {
+            const int64_t Capacity;
+            std::unique_ptr<std::atomic<T>[]> Slots;
+
+            explicit Ring(int64_t capacity) : Capacity(capacity), Slots(new std::atomic<T>[static_cast<size_t>(capacity)]) {}
+
+            T Get(int64_t index) const noexcept {
+                return Slots[static_cast<size_t>(index & (Capacity - 1))].load(std::memory_order_relaxed);
+            }
+
+            void Put(int64_t index, T item) noexcept {
+                Slots[static_cast<size_t>(index & (Capacity - 1))].store(item, std::memory_order_relaxed);
+            }
+        };
+
+        std::atomic<int64_t> Top{ 0 };
+        std::atomic<int64_t> Bottom{ 0 };
+        std::atomic<Ring*> Buffer;
+        /**
+         * @brief Outgrown rings, a thief may still be reading one so they live as long as the deque.
+         */
+        std::vector<std::unique_ptr<Ring>> Rings;
+
+    public:
+        explicit WorkStealingDeque(int64_t capacity = 256) {
+            Rings.emplace_back(new Ring(capacity));
+            Buffer.store(Rings.back().get(), std::memory_order_relaxed);
+        }
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        void Push(T item) {
+            const int64_t b = Bottom.load(std::memory_order_relaxed);
+            const int64_t t = Top.load(std::memory_order_acquire);
+            Ring* ring = Buffer.load(std::memory_order_relaxed);
+            if (b - t > ring->Capacity - 1) {
+                Rings.emplace_back(new Ring(ring->Capacity * 2));
+                Ring* grown = Rings.back().get();
+                for (int64_t i = t; i < b; i++) {
+                    grown->Put(i, ring->Get(i));
+                }
+                Buffer.store(grown, std::memory_order_release);
+                ring = grown;
+            }
+            ring->Put(b, item);
+            //Release store rather than fence and relaxed store: the same on x86 and visible to race detectors.
+            Bottom.store(b + 1, std::memory_order_release);
+        }
+
+        T Pop() noexcept {
+            const int64_t b = Bottom.load(std::memory_order_relaxed) - 1;
+            Ring* ring = Buffer.load(std::memory_order_relaxed);
+            Bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = Top.load(std::memory_order_relaxed);
+            if (t > b) {
+                Bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            T item = ring->Get(b);
+            if (t == b) {
+                //Last item, race the thieves for it.
+                if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                Bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        T Steal() noexcept {
+            int64_t t = Top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t b = Bottom.load(std::memory_order_acquire);
+            if (t >= b) {
+                return nullptr;
+            }
+            T item = Buffer.load(std::memory_order_acquire)->Get(t);
+            if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+        bool Empty() const noexcept {
+            return Bottom.load(std::memory_order_relaxed) <= Top.load(std::memory_order_relaxed);
+        }
+    };
+
+    class WorkStealingPool final : public IExecutor {
+    private:
+        struct Worker {
+            WorkStealingDeque<Task*> Deque;
+            std::thread Thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> Workers;
+        /**
+         * @brief Submitters finding a ring full run queued tasks until there is room.
+         */
+        static constexpr size_t InjectionCapacity = 4096;
+        /**
+         * @brief Injected tasks a worker takes at once.
+         */
+        static constexpr size_t InjectionBatch = 16;
+        MPMCQueue<Task> HighPriority{ InjectionCapacity };
+        MPMCQueue<Task> Injection{ InjectionCapacity };
+        MPMCQueue<Task> LowPriority{ InjectionCapacity };
+
+        std::atomic<size_t> Sleepers{ 0 };
+        /**
+         * @brief Futex word of parked workers, bumped on every wake-up.
+         */
+        std::atomic<uint32_t> WakeEpoch{ 0 };
+        std::atomic<bool> Stopping{ false };
+        std::function<void()> OnWorkerStart;
+        CoreBusyTime* BusyTime;
+
+        void WorkerLoop(size_t index) noexcept;
+        bool FindTask(size_t self, Task& task) noexcept;
+        bool TakeInjected(MPMCQueue<Task>& queue, size_t self, Task& task) noexcept;
+        bool HasVisibleWork() const noexcept;
+        void Wake(size_t count) noexcept;
+        void Inject(Task* tasks, size_t count, TaskPriority priority) noexcept;
+
+    public:
+        /**
+         * @param threadCount Number of workers, at least 1.
+         * @param onWorkerStart Called by every worker before it runs tasks, e.g. to pin itself.
+         * @param busyTime Receives the time workers spend running tasks if not null, must outlive the pool.
+         */
+        explicit WorkStealingPool(size_t threadCount, std::function<void()> onWorkerStart = nullptr,
+            CoreBusyTime* busyTime = nullptr);
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        /**
+         * @brief Queues a task, on the calling worker's own deque if called from within the pool.
+         * High priority tasks submitted from outside jump the injection queue, affinity is ignored.
+         */
+        void Submit(Task task, TaskPriority priority = TaskPriority::Normal, uint64_t affinityMask = 0) override;
+
+        void SubmitBatch(Task* tasks, size_t count, TaskPriority priority = TaskPriority::Normal, uint64_t affinityMask = 0) override;
+
+        /**
+         * @brief Runs one queued task on the calling thread, so threads waiting on the pool help instead of blocking.
+         * @returns false if no task was found.
+         */
+        bool RunPendingTask() noexcept override;
+
+        size_t GetConcurrency() const noexcept override { return Workers.size(); }
+
+        /**
+         * @brief Stops and joins the workers, tasks still queued are dropped without running.
+         */
+        ~WorkStealingPool();
+    };
+
+    /**
+     * @brief Tasks that are waited on together. Without a pool they run inline.
+     */
+    class TaskGroup final {
+    private:
+        IExecutor* Executor;
+        std::atomic<size_t> Pending{ 0 };
+
+    public:
+        explicit TaskGroup(IExecutor* executor) noexcept : Executor(executor) {}
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void Run(IExecutor::Task task);
+
+        /**
+         * @brief Returns once every task of the group ran, running queued tasks meanwhile.
+         */
+        void Wait() noexcept;
+
+        ~TaskGroup() { Wait(); }
+    };
+
+    /**
+     * @brief Calls fn(i) for every i below count, spread over the executor in a few chunks per worker.
+     * Runs inline without an executor or for a single item.
+     *
+     * The chunks are submitted as one batch, with one wake-up. A chunk task only holds a pointer and its index,
+     * small enough for std::function to store without allocating.
+     */
+    template<class Fn>
+    void ParallelFor(IExecutor* executor, size_t count, Fn&& fn) {
+        if (!executor || count < 2) {
+            for (size_t i = 0; i < count; i++) {
+                fn(i);
+            }
+            return;
+        }
+        constexpr size_t MaxChunks = 64;
+        //A few chunks per worker balance uneven items without flooding the deques.
+        const size_t chunks = (std::min)((std::min)(count, (std::max)(executor->GetConcurrency(), size_t(1)) * 4), MaxChunks);
+        std::atomic<size_t> pending{ chunks };
+        auto runChunk = [&fn, &pending, chunks, count](size_t chunk) {
+            for (size_t i = chunk * count / chunks; i < (chunk + 1) * count / chunks; i++) {
+                fn(i);
+            }
+            //Last touch of the frame, the wait below may return right after.
+            pending.fetch_sub(1, std::memory_order_release);
+        };
+        const auto* body = &runChunk;
+        IExecutor::Task tasks[MaxChunks];
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            tasks[chunk] = [body, chunk] { (*body)(chunk); };
+        }
+        executor->SubmitBatch(tasks, chunks);
+        while (pending.load(std::memory_order_acquire)) {
+            if (!executor->RunPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+}
@@ -0,0 +1,223 @@
+// FurrLogDecoder.cpp : Renders a binary log written through Logger::setBinaryOutput as text.
+//
+// Usage: FurrLogDecoder <binary log> [text output]
+//
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ctime>
+#include "LogEvent.h"
+
+using namespace NuAtlas;
+
+namespace {
+    /**
+     * @brief Reads the records of a binary log, returns false at the end or on a truncated record.
+     */
+    class Reader {
+    public:
+        explicit Reader(const std::vector<char>& data) : Data(data) {}
+
+        template<class T>
+        bool Get(T& value) noexcept {
+            if (Data.size() - Position < sizeof(T)) {
+                return false;
+            }
+            std::memcpy(&value, Data.data() + Position, sizeof(T));
+            Position += sizeof(T);
+            return true;
+        }
+
+        bool GetBytes(std::string& out, size_t size) {
+            if (Data.size() - Position < size) {
+                return false;
+            }
+            out.assign(Data.data() + Position, size);
+            Position += size;
+            return true;
+        }
+
+        const uint8_t* Skip(size_t size) noexcept {
+            if (Data.size() - Position < size) {
+                return nullptr;
+            }
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(Data.data()) + Position;
+            Position += size;
+            return bytes;
+        }
+
+        bool AtEnd() const noexcept { return Position == Data.size(); }
+        size_t Tell() const noexcept { return Position; }
+        void Seek(size_t position) noexcept { Position = position; }
+
+    private:
+        const std::vector<char>& Data;
+        size_t Position = 0;
+    };
+
+    struct Calibration {
+        int64_t Ticks;
+        int64_t UnixNanos;
+    };
+
+    const char* LevelName(uint8_t level) noexcept {
+        static const char* const names[] = { "Debug", "Info", "Warning", "Error", "Critical" };
+        return level < 5 ? names[level] : "Unknown";
+    }
+
+    /**
+     * @brief Appends a Unix time in nanoseconds as local time.
+     */
+    void AppendTime(std::string& out, int64_t unixNanos) {
+        const std::time_t seconds = static_cast<std::time_t>(unixNanos / 1000000000);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        char buf[40];
+        const size_t length = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local);
+        std::snprintf(buf + length, sizeof(buf) - length, ".%09lld", static_cast<long long>(unixNanos % 1000000000));
+        out += buf;
+    }
+
+    bool ReadDescriptor(Reader& reader, uint32_t& id, LogEventDescriptor& descriptor) {
+        uint8_t level = 0;
+        uint8_t argCount = 0;
+        uint16_t length = 0;
+        std::string args;
+        if (!reader.Get(id) || !reader.Get(level) || !reader.Get(argCount) || !reader.GetBytes(args, argCount)) {
+            return false;
+        }
+        descriptor.Level = static_cast<LogLevel>(level);
+        descriptor.Args.assign(reinterpret_cast<const LogArgType*>(args.data()), reinterpret_cast<const LogArgType*>(args.data()) + args.size());
+        if (!reader.Get(length) || !reader.GetBytes(descriptor.Format, length)) {
+            return false;
+        }
+        return reader.Get(length) && reader.GetBytes(descriptor.File, length) && reader.Get(descriptor.Line);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: FurrLogDecoder <binary log> [text output]\n";
+        return 1;
+    }
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input) {
+        std::cerr << "Error: could not open " << argv[1] << '\n';
+        return 1;
+    }
+    const std::vector<char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(LogFormat::Magic) || std::memcmp(data.data(), LogFormat::Magic, sizeof(LogFormat::Magic)) != 0) {
+        std::cerr << "Error: " << argv[1] << " is not a Furrballs binary log\n";
+        return 1;
+    }
+    std::ofstream file;
+    if (argc > 2) {
+        file.open(argv[2]);
+        if (!file) {
+            std::cerr << "Error: could not open " << argv[2] << '\n';
+            return 1;
+        }
+    }
+    std::ostream& output = argc > 2 ? static_cast<std::ostream&>(file) : std::cout;
+
+    Reader reader(data);
+    reader.Seek(sizeof(LogFormat::Magic));
+    const size_t start = reader.Tell();
+
+    //First pass: the first and last calibrations give the tick rate over the whole log.
+    std::vector<Calibration> calibrations;
+    std::unordered_map<uint32_t, LogEventDescriptor> descriptors;
+    bool truncated = false;
+    while (!reader.AtEnd() && !truncated) {
+        uint8_t tag = 0;
+        reader.Get(tag);
+        if (tag == LogFormat::Calibration) {
+            Calibration calibration{};
+            truncated = !reader.Get(calibration.Ticks) || !reader.Get(calibration.UnixNanos);
+            if (!truncated) {
+                calibrations.push_back(calibration);
+            }
+        }
+        else if (tag == LogFormat::Descriptor) {
+            uint32_t id = 0;
+            LogEventDescriptor descriptor{};
+            truncated = !ReadDescriptor(reader, id, descriptor);
+            if (!truncated) {
+                descriptors[id] = std::move(descriptor);
+            }
+        }
+        else if (tag == LogFormat::Event) {
+            uint32_t id = 0;
+            int64_t ticks = 0;
+            const auto found = reader.Get(id) && reader.Get(ticks) ? descriptors.find(id) : descriptors.end();
+            truncated = found == descriptors.end() || !reader.Skip(LogFormat::PayloadSize(found->second));
+        }
+        else {
+            truncated = true;
+        }
+    }
+    const size_t end = truncated ? reader.Tell() : data.size();
+    if (truncated) {
+        std::cerr << "Warning: the log is truncated or corrupted after byte " << end << ", the rest is ignored\n";
+    }
+
+    double nanosPerTick = 0;
+    if (calibrations.size() > 1 && calibrations.back().Ticks != calibrations.front().Ticks) {
+        nanosPerTick = static_cast<double>(calibrations.back().UnixNanos - calibrations.front().UnixNanos)
+            / static_cast<double>(calibrations.back().Ticks - calibrations.front().Ticks);
+    }
+    else {
+        std::cerr << "Warning: not enough calibrations to convert ticks, times are raw ticks\n";
+    }
+
+    //Second pass: render the events.
+    reader.Seek(start);
+    std::string line;
+    while (reader.Tell() < end) {
+        uint8_t tag = 0;
+        reader.Get(tag);
+        if (tag == LogFormat::Calibration) {
+            reader.Skip(sizeof(int64_t) * 2);
+        }
+        else if (tag == LogFormat::Descriptor) {
+            uint32_t id = 0;
+            LogEventDescriptor descriptor{};
+            ReadDescriptor(reader, id, descriptor);
+        }
+        else {
+            uint32_t id = 0;
+            int64_t ticks = 0;
+            reader.Get(id);
+            reader.Get(ticks);
+            const LogEventDescriptor& descriptor = descriptors[id];
+            const uint8_t* payload = reader.Skip(LogFormat::PayloadSize(descriptor));
+            line.clear();
+            if (nanosPerTick > 0) {
+                AppendTime(line, calibrations.front().UnixNanos
+                    + static_cast<int64_t>(static_cast<double>(ticks - calibrations.front().Ticks) * nanosPerTick));
+            }
+            else {
+                line += std::to_string(ticks);
+            }
+            line += " [";
+            line += LevelName(static_cast<uint8_t>(descriptor.Level));
+            line += "] ";
+            LogFormat::AppendEvent(line, descriptor, payload);
+            line += " (";
+            line += descriptor.File;
+            line += ':';
+            line += std::to_string(descriptor.Line);
+            line += ")\n";
+            output << line;
+        }
+    }
+    return 0;
+}